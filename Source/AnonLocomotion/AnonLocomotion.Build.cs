@@ -41,6 +41,8 @@ public class AnonLocomotion : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"Json",
+				"NetCore",
 				// "Slate",
 				// "SlateCore",
 				// ... add private dependencies that you statically link with here ...	
@@ -2,16 +2,45 @@
 
 #include "AnimNotify/AnimNotify_CameraShake.h"
 
+#include "Camera/AnonPlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+
 void UAnimNotify_CameraShake::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
 	const FAnimNotifyEventReference& EventReference)
 {
 	Super::Notify(MeshComp, Animation, EventReference);
 
-	if (const APawn* OwnerPawn = Cast<APawn>(MeshComp->GetOwner()))
+	if (!ShakeClass || !MeshComp) return;
+
+	const AActor* MeshOwner = MeshComp->GetOwner();
+	if (!MeshOwner) return;
+
+	UWorld* World = MeshComp->GetWorld();
+	check(World);
+
+	// Nobody looks through a camera on a dedicated server, and remote players play the animation themselves
+	if (World->GetNetMode() == NM_DedicatedServer) return;
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
 	{
-		if (APlayerController* OwnerController = Cast<APlayerController>(OwnerPawn->GetController()))
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController || !PlayerController->IsLocalController() || !PlayerController->PlayerCameraManager)
+		{
+			continue;
+		}
+
+		const bool bOwnCharacter = PlayerController->GetViewTarget() == MeshOwner;
+		if (!bOwnCharacter && !bShakeNearbyCameras) continue;
+
+		if (AAnonPlayerCameraManager* CameraManager = Cast<AAnonPlayerCameraManager>(PlayerController->PlayerCameraManager))
+		{
+			CameraManager->QueueLocalCameraShake(ShakeClass, Scale, MeshOwner->GetActorLocation(), InnerRadius,
+			                                     bOwnCharacter ? 0.0f : OuterRadius, Falloff);
+		}
+		else if (bOwnCharacter)
 		{
-			OwnerController->ClientStartCameraShake(ShakeClass, Scale);
+			PlayerController->PlayerCameraManager->StartCameraShake(ShakeClass, Scale);
 		}
 	}
 }
@@ -2,14 +2,17 @@
 
 #include "AnimNotify/AnimNotify_Footstep.h"
 
-#include "Components/AudioComponent.h"
 #include "Data/LocomotionStruct.h"
-#include "Kismet/GameplayStatics.h"
-#include "NiagaraFunctionLibrary.h"
+#include "Library/LocomotionProfiling.h"
+#include "Subsystems/FootstepFXSubsystem.h"
+
+static const FName NAME_Mask_FootstepSound(TEXT("Mask_FootstepSound"));
 
 void UAnimNotify_Footstep::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
                                   const FAnimNotifyEventReference& EventReference)
 {
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_FootstepNotify);
+
 	Super::Notify(MeshComp, Animation, EventReference);
 	
 	if (!MeshComp) return;
@@ -19,128 +22,40 @@ void UAnimNotify_Footstep::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenc
 
 	if (HitDataTable)
 	{
-		const UWorld* World = MeshComp->GetWorld();
+		UWorld* World = MeshComp->GetWorld();
 		check(World);
 
-		const FVector FootLocation = MeshComp->GetSocketLocation(FootSocketName);
-		const FRotator FootRotation = MeshComp->GetSocketRotation(FootSocketName);
-		const FVector TraceEnd = FootLocation - MeshOwner->GetActorUpVector() * TraceLength;
-
-		FHitResult Hit;
-		UKismetSystemLibrary::LineTraceSingle(MeshOwner, FootLocation, TraceEnd, TraceChannel, true, MeshOwner->Children,
-        		                                          DrawDebugType, Hit, true);
-
-		if (!Hit.bBlockingHit || !Hit.PhysMaterial.Get()) return;
-
-		const EPhysicalSurface SurfaceType = Hit.PhysMaterial.Get()->SurfaceType;
+		UFootstepFXSubsystem* FootstepFX = World->GetSubsystem<UFootstepFXSubsystem>();
+		if (!FootstepFX) return;
 
-		check(IsInGameThread());
-		checkNoRecursion();
-		static TArray<FHitFX*> HitFXRows;
-		HitFXRows.Reset();
+		// Starts the async preload on first use, a no-op afterwards
+		FootstepFX->RegisterTable(HitDataTable);
 
-		HitDataTable->GetAllRows<FHitFX>("", HitFXRows);
+		// The ground trace happens in the subsystem, batched with every other footstep of the frame
+		FFootstepFXRequest Request;
+		Request.Mesh = MeshComp;
+		Request.FootSocketName = FootSocketName;
+		Request.Table = HitDataTable;
+		Request.TraceChannel = UEngineTypes::ConvertToCollisionChannel(TraceChannel);
+		Request.TraceLength = TraceLength;
+		Request.DrawDebugType = DrawDebugType;
+		Request.SoundParameterName = SoundParameterName;
+		Request.FootstepType = FootstepType;
+		Request.PitchMultiplier = PitchMultiplier;
+		Request.DecalScale = FVector(bMirrorDecalX ? -1.0f : 1.0f, bMirrorDecalY ? -1.0f : 1.0f, bMirrorDecalZ ? -1.0f : 1.0f);
+		Request.bSpawnSound = bSpawnSound;
+		Request.bSpawnNiagara = bSpawnNiagara;
+		Request.bSpawnDecal = bSpawnDecal;
 
-		const FHitFX* HitFX;
-		if (const auto FoundResult = HitFXRows.FindByPredicate([&](const FHitFX* Value)
-			{
-				return SurfaceType == Value->SurfaceType;
-			})
-		)
+		Request.VolumeMultiplier = VolumeMultiplier;
+		const UAnimInstance* AnimInstance = MeshComp->GetAnimInstance();
+		if (bSpawnSound && !bOverrideMaskCurve && AnimInstance)
 		{
-			HitFX = *FoundResult;
-		}
-		else if (const auto DefaultResult = HitFXRows.FindByPredicate([&](const FHitFX* Value)
-		{
-			return EPhysicalSurface::SurfaceType_Default == Value->SurfaceType;
-		}))
-		{
-			HitFX = *DefaultResult;
-		}
-		else
-		{
-			return;
-		}
-		
-		if (bSpawnSound && HitFX->Sound.LoadSynchronous())
-		{
-			UAudioComponent* SpawnedSound = nullptr;
-		
-			const float MaskCurveValue = MeshComp->GetAnimInstance()->GetCurveValue(
-				"Mask_FootstepSound");
-			const float FinalVolMult = bOverrideMaskCurve
-				                           ? VolumeMultiplier
-				                           : VolumeMultiplier * (1.0f - MaskCurveValue);
-		
-			switch (HitFX->SoundSpawnType)
-			{
-			case ESpawnType::Location:
-				SpawnedSound = UGameplayStatics::SpawnSoundAtLocation(
-					World, HitFX->Sound.Get(), Hit.Location + HitFX->SoundLocationOffset,
-					HitFX->SoundRotationOffset, FinalVolMult, PitchMultiplier);
-				break;
-		
-			case ESpawnType::Attached:
-				SpawnedSound = UGameplayStatics::SpawnSoundAttached(HitFX->Sound.Get(), MeshComp, FootSocketName,
-				                                                    HitFX->SoundLocationOffset,
-				                                                    HitFX->SoundRotationOffset,
-				                                                    HitFX->SoundAttachmentType, true, FinalVolMult,
-				                                                    PitchMultiplier);
-		
-				break;
-			}
-			if (SpawnedSound)
-			{
-				SpawnedSound->SetIntParameter(SoundParameterName, static_cast<int32>(FootstepType));
-			}
-		}
-		
-		if (bSpawnNiagara && HitFX->NiagaraSystem.LoadSynchronous())
-		{
-			const FVector Location = Hit.Location + MeshOwner->GetTransform().TransformVector(
-				HitFX->DecalLocationOffset);
-		
-			switch (HitFX->NiagaraSpawnType)
-			{
-			case ESpawnType::Location:
-				UNiagaraFunctionLibrary::SpawnSystemAtLocation(
-					World, HitFX->NiagaraSystem.Get(), Location, FootRotation + HitFX->NiagaraRotationOffset);
-				break;
-		
-			case ESpawnType::Attached:
-				UNiagaraFunctionLibrary::SpawnSystemAttached(
-					HitFX->NiagaraSystem.Get(), MeshComp, FootSocketName, HitFX->NiagaraLocationOffset,
-					HitFX->NiagaraRotationOffset, HitFX->NiagaraAttachmentType, true);
-				break;
-			}
-		}
-		
-		if (bSpawnDecal && HitFX->DecalMaterial.LoadSynchronous())
-		{
-			const FVector Location = Hit.Location + MeshOwner->GetTransform().TransformVector(
-				HitFX->DecalLocationOffset);
-		
-			const FVector DecalSize = FVector(bMirrorDecalX ? -HitFX->DecalSize.X : HitFX->DecalSize.X,
-			                                  bMirrorDecalY ? -HitFX->DecalSize.Y : HitFX->DecalSize.Y,
-			                                  bMirrorDecalZ ? -HitFX->DecalSize.Z : HitFX->DecalSize.Z);
-		
-			switch (HitFX->DecalSpawnType)
-			{
-			case ESpawnType::Location:
-				UGameplayStatics::SpawnDecalAtLocation(
-					World, HitFX->DecalMaterial.Get(), DecalSize, Location,
-					FootRotation + HitFX->DecalRotationOffset, HitFX->DecalLifeSpan);
-				break;
-		
-			case ESpawnType::Attached:
-				UGameplayStatics::SpawnDecalAttached(HitFX->DecalMaterial.Get(), DecalSize,
-				                                                    Hit.Component.Get(), NAME_None, Location,
-				                                                    FootRotation + HitFX->DecalRotationOffset,
-				                                                    HitFX->DecalAttachmentType,
-				                                                    HitFX->DecalLifeSpan);
-				break;
-			}
+			LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CurvesRead, 1);
+			Request.VolumeMultiplier *= 1.0f - AnimInstance->GetCurveValue(NAME_Mask_FootstepSound);
 		}
+
+		FootstepFX->QueueFootstep(Request);
 	}
 }
 
@@ -2,40 +2,51 @@
 
 #include "AnimNotify/NotifyState_EarlyBlendOut.h"
 
+#include "Animation/AnimMontage.h"
 #include "Characters/AnonCharacter.h"
 
-void UNotifyState_EarlyBlendOut::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
-                                           float FrameDeltaTime, const FAnimNotifyEventReference& EventReference)
+void UNotifyState_EarlyBlendOut::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+                                            float TotalDuration, const FAnimNotifyEventReference& EventReference)
 {
-	Super::NotifyTick(MeshComp, Animation, FrameDeltaTime, EventReference);
+	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
 
-	UAnimInstance* AnimInstance = MeshComp->GetAnimInstance();
-	
-	if (!MeshComp || !AnimInstance) return;
+	if (!MeshComp || !MeshComp->GetAnimInstance()) return;
 
-	const AAnonCharacter* OwnerCharacter = Cast<AAnonCharacter>(MeshComp->GetOwner());
+	AAnonCharacter* OwnerCharacter = Cast<AAnonCharacter>(MeshComp->GetOwner());
 	if (!OwnerCharacter) return;
 
-	bool bStopMontage = false;
-	if (bCheckMovementState && OwnerCharacter->GetMovementState() == MovementStateEquals)
-	{
-		bStopMontage = true;
-	}
-	else if (bCheckStance && OwnerCharacter->GetStance() == StanceEquals)
-	{
-		bStopMontage = true;
-	}
-	else if (bCheckMovementInput && OwnerCharacter->HasMovementInput())
-	{
-		bStopMontage = true;
-	}
+	FEarlyBlendOutCondition Condition;
+	Condition.Source = this;
+	Condition.AnimInstance = MeshComp->GetAnimInstance();
+	Condition.Montage = GetWindowMontage(Animation);
+	Condition.BlendOutTime = BlendOutTime;
+	Condition.bCheckMovementState = bCheckMovementState;
+	Condition.MovementStateEquals = MovementStateEquals;
+	Condition.bCheckStance = bCheckStance;
+	Condition.StanceEquals = StanceEquals;
+	Condition.bCheckMovementInput = bCheckMovementInput;
+
+	OwnerCharacter->RegisterEarlyBlendOut(Condition);
+}
 
-	if (bStopMontage)
+void UNotifyState_EarlyBlendOut::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+                                          const FAnimNotifyEventReference& EventReference)
+{
+	Super::NotifyEnd(MeshComp, Animation, EventReference);
+
+	if (!MeshComp) return;
+
+	if (AAnonCharacter* OwnerCharacter = Cast<AAnonCharacter>(MeshComp->GetOwner()))
 	{
-		AnimInstance->Montage_Stop(BlendOutTime, ThisMontage);
+		OwnerCharacter->UnregisterEarlyBlendOut(this, GetWindowMontage(Animation));
 	}
 }
 
+UAnimMontage* UNotifyState_EarlyBlendOut::GetWindowMontage(UAnimSequenceBase* Animation) const
+{
+	return ThisMontage ? ThisMontage.Get() : Cast<UAnimMontage>(Animation);
+}
+
 FString UNotifyState_EarlyBlendOut::GetNotifyName_Implementation() const
 {
 	return FString(TEXT("Early Blend Out"));
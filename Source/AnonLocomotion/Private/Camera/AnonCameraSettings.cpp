@@ -0,0 +1,21 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Camera/AnonCameraSettings.h"
+
+const FCameraStateRule* UAnonCameraSettings::FindRule(const FCameraStateKey& Key) const
+{
+	const FCameraStateRule* BestRule = nullptr;
+	int32 BestSpecificity = INDEX_NONE;
+
+	for (const FCameraStateRule& Rule : Rules)
+	{
+		const int32 Specificity = Rule.Match(Key);
+		if (Specificity > BestSpecificity)
+		{
+			BestSpecificity = Specificity;
+			BestRule = &Rule;
+		}
+	}
+
+	return BestRule;
+}
@@ -2,6 +2,38 @@
 
 #include "Camera/AnonPlayerCameraBehavior.h"
 
+#include "Characters/AnonCharacter.h"
+
+void UAnonPlayerCameraBehavior::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	SyncCharacterStates();
+}
+
+void UAnonPlayerCameraBehavior::SetCharacter(AAnonCharacter* NewCharacter)
+{
+	Character = NewCharacter;
+	SyncCharacterStates(true);
+}
+
+void UAnonPlayerCameraBehavior::SyncCharacterStates(bool bForce)
+{
+	if (!Character.IsValid()) return;
+
+	const uint32 StateVersion = Character->GetStateVersion();
+	if (!bForce && StateVersion == CachedStateVersion) return;
+	CachedStateVersion = StateVersion;
+
+	MovementState = Character->GetMovementState();
+	MovementAction = Character->GetMovementAction();
+	bRightShoulder = Character->IsRightShoulder();
+	Gait = Character->GetGait();
+	SetRotationMode(Character->GetRotationMode());
+	Stance = Character->GetStance();
+	ViewMode = Character->GetViewMode();
+}
+
 void UAnonPlayerCameraBehavior::SetRotationMode(ERotationMode RotationMode)
 {
 	bVelocityDirection = RotationMode == ERotationMode::VelocityDirection;
@@ -2,9 +2,11 @@
 
 #include "Camera/AnonPlayerCameraManager.h"
 
+#include "Camera/AnonCameraSettings.h"
 #include "Camera/AnonPlayerCameraBehavior.h"
 #include "Characters/AnonCharacter.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Library/LocomotionProfiling.h"
 
 const FName NAME_CameraBehavior(TEXT("CameraBehavior"));
 const FName NAME_CameraOffset_X(TEXT("CameraOffset_X"));
@@ -39,29 +41,140 @@ void AAnonPlayerCameraManager::OnPossess(AAnonCharacter* NewCharacter)
 	if (UAnonPlayerCameraBehavior* CastedBehv = Cast<UAnonPlayerCameraBehavior>(CameraBehavior->GetAnimInstance()))
 	{
 		NewCharacter->SetCameraBehavior(CastedBehv);
-		CastedBehv->MovementState = NewCharacter->GetMovementState();
-		CastedBehv->MovementAction = NewCharacter->GetMovementAction();
-		CastedBehv->bRightShoulder = NewCharacter->IsRightShoulder();
-		CastedBehv->Gait = NewCharacter->GetGait();
-		CastedBehv->SetRotationMode(NewCharacter->GetRotationMode());
-		CastedBehv->Stance = NewCharacter->GetStance();
-		CastedBehv->ViewMode = NewCharacter->GetViewMode();
+		CastedBehv->SetCharacter(NewCharacter);
+	}
+
+	// The evaluator replaces the anim graph entirely, don't pay for its tick and pose evaluation
+	CameraBehavior->SetComponentTickEnabled(!UsesCameraParamEvaluator());
+	if (UsesCameraParamEvaluator())
+	{
+		CachedStateVersion = NewCharacter->GetStateVersion();
+		CameraParamEvaluator.Reset(*CameraSettings, MakeCameraStateKey(*NewCharacter));
 	}
 	
+	CameraOcclusion.Reset();
+	CameraTarget.Initialize(*NewCharacter);
+	CameraTarget.Evaluate(CameraTargetPoints);
+
 	// Initial position
-	const FVector& TPSLoc = ControlledCharacter->GetThirdPersonPivotTarget().GetLocation();
+	const FVector& TPSLoc = CameraTargetPoints.PivotTarget.GetLocation();
 	SetActorLocation(TPSLoc);
 	SmoothedPivotTarget.SetLocation(TPSLoc);
 }
 
-float AAnonPlayerCameraManager::GetCameraBehaviorParam(FName CurveName) const
+void AAnonPlayerCameraManager::UpdateCamera(float DeltaTime)
+{
+	// Before the modifiers run, so shakes of this frame's notifies already apply
+	StartQueuedCameraShakes();
+
+	Super::UpdateCamera(DeltaTime);
+}
+
+void AAnonPlayerCameraManager::QueueLocalCameraShake(TSubclassOf<UCameraShakeBase> ShakeClass, float Scale,
+                                                     const FVector& Epicenter, float InnerRadius, float OuterRadius,
+                                                     float Falloff)
+{
+	if (!ShakeClass) return;
+
+	if (OuterRadius > 0.0f)
+	{
+		Scale *= CalcRadialShakeScale(this, Epicenter, InnerRadius, OuterRadius, Falloff);
+	}
+	if (Scale < MinCameraShakeScale) return;
+
+	// Several characters hitting the same shake in one frame only make it stronger
+	for (FQueuedCameraShake& Queued : QueuedCameraShakes)
+	{
+		if (Queued.ShakeClass == ShakeClass)
+		{
+			Queued.Scale = FMath::Max(Queued.Scale, Scale);
+			return;
+		}
+	}
+	QueuedCameraShakes.Add({ShakeClass, Scale});
+}
+
+void AAnonPlayerCameraManager::StartQueuedCameraShakes()
 {
-	UAnimInstance* Inst = CameraBehavior->GetAnimInstance();
-	if (Inst)
+	if (QueuedCameraShakes.Num() == 0) return;
+
+	QueuedCameraShakes.Sort([](const FQueuedCameraShake& A, const FQueuedCameraShake& B)
+	{
+		return A.Scale > B.Scale;
+	});
+
+	const int32 NumToStart = FMath::Min(QueuedCameraShakes.Num(), MaxCameraShakesPerFrame);
+	for (int32 i = 0; i < NumToStart; ++i)
 	{
-		return Inst->GetCurveValue(CurveName);
+		StartCameraShake(QueuedCameraShakes[i].ShakeClass, QueuedCameraShakes[i].Scale);
+	}
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CameraShakesStarted, NumToStart);
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CameraShakesOverBudget, QueuedCameraShakes.Num() - NumToStart);
+	QueuedCameraShakes.Reset();
+}
+
+FCameraStateKey AAnonPlayerCameraManager::MakeCameraStateKey(const AAnonCharacter& Character)
+{
+	FCameraStateKey Key;
+	Key.MovementState = Character.GetMovementState();
+	Key.Gait = Character.GetGait();
+	Key.Stance = Character.GetStance();
+	Key.RotationMode = Character.GetRotationMode();
+	Key.ViewMode = Character.GetViewMode();
+	Key.bRightShoulder = Character.IsRightShoulder();
+	return Key;
+}
+
+const FCameraBehaviorParams& AAnonPlayerCameraManager::UpdateCameraParams(float DeltaTime)
+{
+	if (!UsesCameraParamEvaluator())
+	{
+		GetLegacyCameraParams(CameraParams);
+		return CameraParams;
+	}
+
+	// Keys only need to be rebuilt when the character reports a discrete state change
+	const uint32 StateVersion = ControlledCharacter->GetStateVersion();
+	const bool bKeyChanged = StateVersion != CachedStateVersion;
+	CachedStateVersion = StateVersion;
+
+	CameraParams = CameraParamEvaluator.Update(*CameraSettings,
+	                                           bKeyChanged ? MakeCameraStateKey(*ControlledCharacter) : FCameraStateKey(),
+	                                           bKeyChanged, DeltaTime);
+	return CameraParams;
+}
+
+void AAnonPlayerCameraManager::GetLegacyCameraParams(FCameraBehaviorParams& OutParams) const
+{
+	const UAnimInstance* Inst = CameraBehavior->GetAnimInstance();
+	if (!Inst)
+	{
+		OutParams = FCameraBehaviorParams();
+		return;
+	}
+
+	// Curves missing from the graph read as 0, like UAnimInstance::GetCurveValue
+	OutParams.PivotLagSpeed = OutParams.PivotOffset = OutParams.CameraOffset = FVector::ZeroVector;
+	OutParams.RotationLagSpeed = OutParams.Weight_FirstPerson = OutParams.Override_Debug = 0.0f;
+
+	// Same source as UAnimInstance::GetCurveValue, walked once instead of one lookup per curve
+	for (const TPair<FName, float>& Curve : Inst->GetAnimationCurveList(EAnimCurveType::AttributeCurve))
+	{
+		const FName& Name = Curve.Key;
+		if (Name == NAME_RotationLagSpeed) OutParams.RotationLagSpeed = Curve.Value;
+		else if (Name == NAME_PivotLagSpeed_X) OutParams.PivotLagSpeed.X = Curve.Value;
+		else if (Name == NAME_PivotLagSpeed_Y) OutParams.PivotLagSpeed.Y = Curve.Value;
+		else if (Name == NAME_PivotLagSpeed_Z) OutParams.PivotLagSpeed.Z = Curve.Value;
+		else if (Name == NAME_PivotOffset_X) OutParams.PivotOffset.X = Curve.Value;
+		else if (Name == NAME_PivotOffset_Y) OutParams.PivotOffset.Y = Curve.Value;
+		else if (Name == NAME_PivotOffset_Z) OutParams.PivotOffset.Z = Curve.Value;
+		else if (Name == NAME_CameraOffset_X) OutParams.CameraOffset.X = Curve.Value;
+		else if (Name == NAME_CameraOffset_Y) OutParams.CameraOffset.Y = Curve.Value;
+		else if (Name == NAME_CameraOffset_Z) OutParams.CameraOffset.Z = Curve.Value;
+		else if (Name == NAME_Override_Debug) OutParams.Override_Debug = Curve.Value;
+		else if (Name == NAME_Weight_FirstPerson) OutParams.Weight_FirstPerson = Curve.Value;
 	}
-	return 0.0f;
 }
 
 void AAnonPlayerCameraManager::UpdateViewTargetInternal(FTViewTarget& OutVT, float DeltaTime)
@@ -74,7 +187,7 @@ void AAnonPlayerCameraManager::UpdateViewTargetInternal(FTViewTarget& OutVT, flo
 		FRotator OutRotation;
 		float OutFOV;
 
-		if (OutVT.Target->IsA<AAnonCharacter>())
+		if (CameraTarget.IsValidFor(OutVT.Target))
 		{
 			if (CustomCameraBehavior(DeltaTime, OutLocation, OutRotation, OutFOV))
 			{
@@ -100,46 +213,48 @@ FVector AAnonPlayerCameraManager::CalculateAxisIndependentLag(FVector CurrentLoc
 {
 	CameraRotation.Roll = 0.0f;
 	CameraRotation.Pitch = 0.0f;
-	const FVector UnrotatedCurLoc = CameraRotation.UnrotateVector(CurrentLocation);
-	const FVector UnrotatedTargetLoc = CameraRotation.UnrotateVector(TargetLocation);
+	const FRotationMatrix CameraMatrix(CameraRotation);
+	const FVector UnrotatedCurLoc = CameraMatrix.InverseTransformVector(CurrentLocation);
+	const FVector UnrotatedTargetLoc = CameraMatrix.InverseTransformVector(TargetLocation);
 
 	const FVector ResultVector(
 		FMath::FInterpTo(UnrotatedCurLoc.X, UnrotatedTargetLoc.X, DeltaTime, LagSpeeds.X),
 		FMath::FInterpTo(UnrotatedCurLoc.Y, UnrotatedTargetLoc.Y, DeltaTime, LagSpeeds.Y),
 		FMath::FInterpTo(UnrotatedCurLoc.Z, UnrotatedTargetLoc.Z, DeltaTime, LagSpeeds.Z));
 
-	return CameraRotation.RotateVector(ResultVector);
+	return CameraMatrix.TransformVector(ResultVector);
 }
 
 bool AAnonPlayerCameraManager::CustomCameraBehavior(float DeltaTime, FVector& Location, FRotator& Rotation, float& FOV)
 {
+	LOCOMOTION_BENCHMARK_SCOPE(Camera);
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_CameraBehavior);
+
 	if (!ControlledCharacter.IsValid())
 	{
 		return false;
 	}
 
 	// Step 1: Get Camera Parameters from CharacterBP via the Camera Interface
-	const FTransform& PivotTarget = ControlledCharacter->GetThirdPersonPivotTarget();
-	const FVector& FPTarget = ControlledCharacter->GetFirstPersonCameraTarget();
+	CameraTarget.Evaluate(CameraTargetPoints);
+	const FTransform& PivotTarget = CameraTargetPoints.PivotTarget;
+	const FVector& FPTarget = CameraTargetPoints.FirstPersonTarget;
 	float TPFOV = 90.0f;
 	float FPFOV = 90.0f;
 	bool bRightShoulder = false;
 	ControlledCharacter->GetCameraParameters(TPFOV, FPFOV, bRightShoulder);
+	const FCameraBehaviorParams& Params = UpdateCameraParams(DeltaTime);
 
 	// Step 2: Calculate Target Camera Rotation. Use the Control Rotation and interpolate for smooth camera rotation.
 	TargetCameraRotation = FMath::RInterpTo(GetCameraRotation(),
 	                                                GetOwningPlayerController()->GetControlRotation(), DeltaTime,
-	                                                GetCameraBehaviorParam(NAME_RotationLagSpeed));
+	                                                Params.RotationLagSpeed);
 
 	// Step 3: Calculate the Smoothed Pivot Target (Orange Sphere).
 	// Get the 3P Pivot Target (Green Sphere) and interpolate using axis independent lag for maximum control.
-	const FVector LagSpd(GetCameraBehaviorParam(NAME_PivotLagSpeed_X),
-	                     GetCameraBehaviorParam(NAME_PivotLagSpeed_Y),
-	                     GetCameraBehaviorParam(NAME_PivotLagSpeed_Z));
-
 	const FVector& AxisIndpLag = CalculateAxisIndependentLag(SmoothedPivotTarget.GetLocation(),
-	                                                         PivotTarget.GetLocation(), TargetCameraRotation, LagSpd,
-	                                                         DeltaTime);
+	                                                         PivotTarget.GetLocation(), TargetCameraRotation,
+	                                                         Params.PivotLagSpeed, DeltaTime);
 
 	SmoothedPivotTarget.SetRotation(PivotTarget.GetRotation());
 	SmoothedPivotTarget.SetLocation(AxisIndpLag);
@@ -147,61 +262,40 @@ bool AAnonPlayerCameraManager::CustomCameraBehavior(float DeltaTime, FVector& Lo
 
 	// Step 4: Calculate Pivot Location (BlueSphere). Get the Smoothed
 	// Pivot Target and apply local offsets for further camera control.
-	PivotLocation =
-		SmoothedPivotTarget.GetLocation() +
-		UKismetMathLibrary::GetForwardVector(SmoothedPivotTarget.Rotator()) * GetCameraBehaviorParam(
-			NAME_PivotOffset_X) +
-		UKismetMathLibrary::GetRightVector(SmoothedPivotTarget.Rotator()) * GetCameraBehaviorParam(
-			NAME_PivotOffset_Y) +
-		UKismetMathLibrary::GetUpVector(SmoothedPivotTarget.Rotator()) * GetCameraBehaviorParam(
-			NAME_PivotOffset_Z);
+	// Forward * X + Right * Y + Up * Z is the offset rotated by the pivot rotation, done with the quat it already holds.
+	PivotLocation = SmoothedPivotTarget.GetLocation() + SmoothedPivotTarget.GetRotation().RotateVector(Params.PivotOffset);
 
 	// Step 5: Calculate Target Camera Location. Get the Pivot location and apply camera relative offsets.
-	TargetCameraLocation = UKismetMathLibrary::VLerp(
-		PivotLocation +
-		UKismetMathLibrary::GetForwardVector(TargetCameraRotation) * GetCameraBehaviorParam(
-			NAME_CameraOffset_X) +
-		UKismetMathLibrary::GetRightVector(TargetCameraRotation) * GetCameraBehaviorParam(NAME_CameraOffset_Y)
-		+
-		UKismetMathLibrary::GetUpVector(TargetCameraRotation) * GetCameraBehaviorParam(NAME_CameraOffset_Z),
-		PivotTarget.GetLocation(),
-		GetCameraBehaviorParam(NAME_Override_Debug));
+	const FRotationMatrix TargetCameraMatrix(TargetCameraRotation);
+	TargetCameraLocation = FMath::Lerp(PivotLocation + TargetCameraMatrix.TransformVector(Params.CameraOffset),
+	                                   PivotTarget.GetLocation(), Params.Override_Debug);
 
 	// Step 6: Trace for an object between the camera and character to apply a corrective offset.
 	// Trace origins are set within the Character BP via the Camera Interface.
-	// Functions like the normal spring arm, but can allow for different trace origins regardless of the pivot
-	FVector TraceOrigin;
-	float TraceRadius;
-	ECollisionChannel TraceChannel = ControlledCharacter->GetThirdPersonTraceParams(TraceOrigin, TraceRadius);
+	// Functions like the normal spring arm, but can allow for different trace origins regardless of the pivot.
+	// The occlusion module sweeps async (result used next frame), probes ahead with feelers and smooths the offset.
 
 	UWorld* World = GetWorld();
 	check(World);
 
-	FCollisionQueryParams Params;
-	Params.AddIgnoredActor(this);
-	Params.AddIgnoredActor(ControlledCharacter.Get());
-
-	FHitResult HitResult;
-	const FCollisionShape SphereCollisionShape = FCollisionShape::MakeSphere(TraceRadius);
-	World->SweepSingleByChannel(HitResult, TraceOrigin, TargetCameraLocation, FQuat::Identity,
-	                                              TraceChannel, SphereCollisionShape, Params);
+	FCollisionQueryParams QueryParams;
+	QueryParams.AddIgnoredActor(this);
+	QueryParams.AddIgnoredActor(ControlledCharacter.Get());
 
-	if (HitResult.IsValidBlockingHit())
-	{
-		TargetCameraLocation += HitResult.Location - HitResult.TraceEnd;
-	}
+	TargetCameraLocation = CameraOcclusion.Update(*World, OcclusionSettings, CameraTargetPoints.TraceOrigin,
+	                                              TargetCameraLocation, TargetCameraMatrix, CameraTargetPoints.TraceRadius,
+	                                              CameraTargetPoints.TraceChannel, QueryParams, DeltaTime);
 
 	// Step 8: Lerp First Person Override and return target camera parameters.
 	FTransform TargetCameraTransform(TargetCameraRotation, TargetCameraLocation, FVector::OneVector);
 	FTransform FPTargetCameraTransform(TargetCameraRotation, FPTarget, FVector::OneVector);
 
 	const FTransform& MixedTransform = UKismetMathLibrary::TLerp(TargetCameraTransform, FPTargetCameraTransform,
-	                                                             GetCameraBehaviorParam(
-		                                                             NAME_Weight_FirstPerson));
+	                                                             Params.Weight_FirstPerson);
 
 	Location = MixedTransform.GetLocation();
 	Rotation = MixedTransform.Rotator();
-	FOV = FMath::Lerp(TPFOV, FPFOV, GetCameraBehaviorParam(NAME_Weight_FirstPerson));
+	FOV = FMath::Lerp(TPFOV, FPFOV, Params.Weight_FirstPerson);
 
 	return true;
 }
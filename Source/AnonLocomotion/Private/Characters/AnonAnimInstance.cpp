@@ -2,11 +2,13 @@
 
 #include "Characters/AnonAnimInstance.h"
 
+#include "Animation/AnimMontage.h"
 #include "Characters/AnonCharacter.h"
 #include "Components/CapsuleComponent.h"
 #include "Curves/CurveVector.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Library/LocomotionMathLibrary.h"
+#include "Library/LocomotionProfiling.h"
 
 static const FName NAME_BasePose_CLF(TEXT("BasePose_CLF"));
 static const FName NAME_BasePose_N(TEXT("BasePose_N"));
@@ -40,6 +42,7 @@ void UAnonAnimInstance::NativeInitializeAnimation()
 {
 	Super::NativeInitializeAnimation();
 	Character = Cast<AAnonCharacter>(TryGetPawnOwner());
+	bStatesSynced = false;
 	if (Character.IsValid())
 	{
 		Character->OnJumpedDelegate.AddUObject(this, &UAnonAnimInstance::OnJumped);
@@ -48,31 +51,43 @@ void UAnonAnimInstance::NativeInitializeAnimation()
 
 void UAnonAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
 {
+	LOCOMOTION_BENCHMARK_SCOPE(AnimUpdate);
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_AnimUpdate);
+
 	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
 
-	if (!Character.IsValid() || DeltaSeconds == 0.f) return;
+	if (!Character.IsValid() || DeltaSeconds == 0.f || Character->IsServerLiteAnimating()) return;
 
 	// Update rest of character information. Others are reflected into anim bp when they're set inside character class
-	CharacterInformation.MovementInputAmount = Character->GetMovementInputAmount();
-	CharacterInformation.bHasMovementInput = Character->HasMovementInput();
-	CharacterInformation.bIsMoving = Character->IsMoving();
-	CharacterInformation.Acceleration = Character->GetAcceleration();
-	CharacterInformation.AimYawRate = Character->GetAimYawRate();
-	CharacterInformation.Speed = Character->GetSpeed();
+	const FLocomotionRuntimeState& State = Character->GetRuntimeState();
+	CharacterInformation.MovementInputAmount = State.MovementInputAmount;
+	CharacterInformation.bHasMovementInput = State.bHasMovementInput;
+	CharacterInformation.bIsMoving = State.bIsMoving;
+	CharacterInformation.Acceleration = State.Acceleration;
+	CharacterInformation.AimYawRate = State.AimYawRate;
+	CharacterInformation.Speed = State.Speed;
 	CharacterInformation.Velocity = Character->GetCharacterMovement()->Velocity;
 	CharacterInformation.MovementInput = Character->GetMovementInput();
-	CharacterInformation.AimingRotation = Character->GetAimingRotation();
+	CharacterInformation.AimingRotation = State.AimingRotation;
 	CharacterInformation.CharacterActorRotation = Character->GetActorRotation();
-	CharacterInformation.ViewMode = Character->GetViewMode();
-	CharacterInformation.PrevMovementState = Character->GetPrevMovementState();
-	LayerBlendingValues.OverlayOverrideState = Character->GetOverlayOverrideState();
-	MovementState = Character->GetMovementState();
-	MovementAction = Character->GetMovementAction();
-	Stance = Character->GetStance();
-	RotationMode = Character->GetRotationMode();
-	Gait = Character->GetGait();
-	OverlayState = Character->GetOverlayState();
-	GroundedEntryState = Character->GetGroundedEntryState();
+
+	// Discrete states only change a few times a minute, copy them when the character reports a change
+	if (!bStatesSynced || State.StateVersion != CachedStateVersion)
+	{
+		bStatesSynced = true;
+		CachedStateVersion = State.StateVersion;
+		
+		CharacterInformation.ViewMode = Character->GetViewMode();
+		CharacterInformation.PrevMovementState = State.PrevMovementState;
+		LayerBlendingValues.OverlayOverrideState = Character->GetOverlayOverrideState();
+		MovementState = State.MovementState;
+		MovementAction = Character->GetMovementAction();
+		Stance = State.Stance;
+		RotationMode = State.RotationMode;
+		Gait = State.Gait;
+		OverlayState = Character->GetOverlayState();
+		GroundedEntryState = Character->GetGroundedEntryState();
+	}
 
 	UpdateAimingValues(DeltaSeconds);
 	UpdateLayerValues();
@@ -136,7 +151,7 @@ void UAnonAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 {
 	Super::NativeUpdateAnimation(DeltaSeconds);
 
-	if (!Character.IsValid() || DeltaSeconds == 0.f) return;
+	if (!Character.IsValid() || DeltaSeconds == 0.f || Character->IsServerLiteAnimating()) return;
 
 	if (MovementState.Grounded() && !Grounded.bShouldMove && CanDynamicTransition())
 	{
@@ -144,11 +159,154 @@ void UAnonAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 	}
 }
 
+void UAnonAnimInstance::UpdateServerLite(float DeltaSeconds)
+{
+	if (!Character.IsValid() || DeltaSeconds == 0.f) return;
+
+	const FLocomotionRuntimeState& State = Character->GetRuntimeState();
+	CharacterInformation.bHasMovementInput = State.bHasMovementInput;
+	CharacterInformation.bIsMoving = State.bIsMoving;
+	CharacterInformation.Speed = State.Speed;
+	CharacterInformation.AimYawRate = State.AimYawRate;
+	CharacterInformation.AimingRotation = State.AimingRotation;
+	CharacterInformation.Velocity = Character->GetCharacterMovement()->Velocity;
+	CharacterInformation.CharacterActorRotation = Character->GetActorRotation();
+	CharacterInformation.ViewMode = Character->GetViewMode();
+	MovementState = State.MovementState;
+	RotationMode = State.RotationMode;
+
+	FRotator Delta = CharacterInformation.AimingRotation - CharacterInformation.CharacterActorRotation;
+	Delta.Normalize();
+	AimingValues.AimingAngle.X = Delta.Yaw;
+
+	const bool bShouldMove = ShouldMoveCheck();
+	if (MovementState.Grounded() && bShouldMove)
+	{
+		// Only the inputs of the YawOffset curve, see GetServerLiteYawOffset
+		const FVelocityBlend& TargetBlend = CalculateVelocityBlend();
+		VelocityBlend.F = FMath::FInterpTo(VelocityBlend.F, TargetBlend.F, DeltaSeconds, Config.VelocityBlendInterpSpeed);
+		VelocityBlend.B = FMath::FInterpTo(VelocityBlend.B, TargetBlend.B, DeltaSeconds, Config.VelocityBlendInterpSpeed);
+		VelocityBlend.L = FMath::FInterpTo(VelocityBlend.L, TargetBlend.L, DeltaSeconds, Config.VelocityBlendInterpSpeed);
+		VelocityBlend.R = FMath::FInterpTo(VelocityBlend.R, TargetBlend.R, DeltaSeconds, Config.VelocityBlendInterpSpeed);
+		UpdateRotationValues();
+	}
+
+	// Same conditions as CanTurnInPlace, a playing montage stands in for the Enable_Transition curve
+	if (MovementState.Grounded() && !bShouldMove && RotationMode.LookingDirection() &&
+		CharacterInformation.ViewMode == EViewMode::ThirdPerson && !IsAnyMontagePlaying())
+	{
+		TurnInPlaceCheck(DeltaSeconds);
+	}
+	else
+	{
+		TurnInPlaceValues.ElapsedDelayTime = 0.f;
+	}
+}
+
+float UAnonAnimInstance::GetServerLiteYawOffset() const
+{
+	// The graph applies each direction's yaw offset to its cycle and blends the cycles by VelocityBlend
+	return VelocityBlend.F * Grounded.FYaw + VelocityBlend.B * Grounded.BYaw
+		+ VelocityBlend.L * Grounded.LYaw + VelocityBlend.R * Grounded.RYaw;
+}
+
+void UAnonAnimInstance::ResetAnimationState()
+{
+	// Nothing may blend in from the previous life of the character
+	StopAllMontages(0.0f);
+	if (const UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(OnPivotTimer);
+		World->GetTimerManager().ClearTimer(PlayDynamicTransitionTimer);
+		World->GetTimerManager().ClearTimer(OnJumpedTimer);
+	}
+	bCanPlayDynamicTransition = true;
+
+	const UAnonAnimInstance* Defaults = GetClass()->GetDefaultObject<UAnonAnimInstance>();
+	CharacterInformation = Defaults->CharacterInformation;
+	MovementState = Defaults->MovementState;
+	MovementAction = Defaults->MovementAction;
+	RotationMode = Defaults->RotationMode;
+	Gait = Defaults->Gait;
+	Stance = Defaults->Stance;
+	OverlayState = Defaults->OverlayState;
+
+	Grounded = Defaults->Grounded;
+	VelocityBlend = Defaults->VelocityBlend;
+	LeanAmount = Defaults->LeanAmount;
+	RelativeAccelerationAmount = Defaults->RelativeAccelerationAmount;
+	GroundedEntryState = Defaults->GroundedEntryState;
+	MovementDirection = Defaults->MovementDirection;
+	InAir = Defaults->InAir;
+	AimingValues = Defaults->AimingValues;
+	SmoothedAimingAngle = Defaults->SmoothedAimingAngle;
+	FlailRate = Defaults->FlailRate;
+	LayerBlendingValues = Defaults->LayerBlendingValues;
+	FootIKValues = Defaults->FootIKValues;
+	TurnInPlaceValues = Defaults->TurnInPlaceValues;
+	RotateInPlace = Defaults->RotateInPlace;
+
+	TraversalState = Defaults->TraversalState;
+	TraversalAction = Defaults->TraversalAction;
+	TraversalDirection = Defaults->TraversalDirection;
+	ClimbStyle = Defaults->ClimbStyle;
+
+	FootGroundHits[0] = FootGroundHits[1] = FFootGroundHit();
+
+	// Discrete states are copied from the character again on the next update
+	bStatesSynced = false;
+}
+
 void UAnonAnimInstance::PlayTransition(const FDynamicMontageParams& Parameters)
 {
-	PlaySlotAnimationAsDynamicMontage(Parameters.Animation, NAME_Grounded___Slot,
-	                                  Parameters.BlendInTime, Parameters.BlendOutTime, Parameters.PlayRate, 1,
-	                                  0.f, Parameters.StartTime);
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MontagesPlayed, 1);
+	PlayPooledSlotAnimation(Parameters.Animation, NAME_Grounded___Slot, Parameters.BlendInTime,
+	                        Parameters.BlendOutTime, Parameters.PlayRate, 1, Parameters.StartTime);
+}
+
+UAnimMontage* UAnonAnimInstance::PlayPooledSlotAnimation(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime,
+                                                         float BlendOutTime, float PlayRate, int32 LoopCount,
+                                                         float StartTime)
+{
+	UAnimMontage* Montage = FindOrCreatePooledMontage(Asset, SlotName, BlendInTime, BlendOutTime, LoopCount);
+	if (!Montage) return nullptr;
+
+	return Montage_Play(Montage, PlayRate, EMontagePlayReturnType::MontageLength, StartTime) > 0.f ? Montage : nullptr;
+}
+
+UAnimMontage* UAnonAnimInstance::FindOrCreatePooledMontage(UAnimSequenceBase* Asset, FName SlotName,
+                                                           float BlendInTime, float BlendOutTime, int32 LoopCount)
+{
+	if (!Asset) return nullptr;
+
+	// A handful of transition and turn assets per character, a linear scan is enough. Blend times are part of the key,
+	// a montage still blending out must not pick up the times of the next call
+	UAnimMontage* Montage = nullptr;
+	for (UAnimMontage* Pooled : DynamicMontagePool)
+	{
+		const FSlotAnimationTrack& Track = Pooled->SlotAnimTracks[0];
+		const FAnimSegment& Segment = Track.AnimTrack.AnimSegments[0];
+		if (Track.SlotName == SlotName && Segment.GetAnimReference() == Asset && Segment.LoopingCount == LoopCount
+			&& Pooled->BlendIn.GetBlendTime() == BlendInTime && Pooled->BlendOut.GetBlendTime() == BlendOutTime)
+		{
+			Montage = Pooled;
+			break;
+		}
+	}
+
+	if (!Montage)
+	{
+		// Play rate is left to Montage_Play, so the montage stays valid for any rate. Blend out is triggered at the end
+		// of the sequence like PlaySlotAnimationAsDynamicMontage did, the turn in place curves need their full weight
+		Montage = UAnimMontage::CreateSlotAnimationAsDynamicMontage(Asset, SlotName, BlendInTime, BlendOutTime, 1.f,
+		                                                            LoopCount, 0.f);
+		if (!Montage) return nullptr;
+
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_DynamicMontagesCreated, 1);
+		DynamicMontagePool.Add(Montage);
+	}
+
+	return Montage;
 }
 
 void UAnonAnimInstance::PlayTransitionChecked(const FDynamicMontageParams& Parameters)
@@ -274,6 +432,8 @@ void UAnonAnimInstance::UpdateAimingValues(float DeltaSeconds)
 
 void UAnonAnimInstance::UpdateLayerValues()
 {
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CurvesRead, 15);
+
 	// Get the Aim Offset weight by getting the opposite of the Aim Offset Mask.
 	LayerBlendingValues.EnableAimOffset = FMath::Lerp(1.f, 0.f, GetCurveValue(NAME_Mask_AimOffset));
 	// Set the Base Pose weights
@@ -302,6 +462,8 @@ void UAnonAnimInstance::UpdateLayerValues()
 
 void UAnonAnimInstance::UpdateFootIK(float DeltaSeconds)
 {
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_UpdateFootIK);
+
 	FVector FootOffsetLTarget = FVector::ZeroVector;
 	FVector FootOffsetRTarget = FVector::ZeroVector;
 
@@ -446,7 +608,7 @@ void UAnonAnimInstance::ResetIKOffsets(float DeltaSeconds)
 
 void UAnonAnimInstance::SetFootOffsets(float DeltaSeconds, FName EnableFootIKCurve, FName IKFootBone,
                                                FName RootBone, FVector& CurLocationTarget, FVector& CurLocationOffset,
-                                               FRotator& CurRotationOffset) const
+                                               FRotator& CurRotationOffset)
 {
 	// Only update Foot IK offset values if the Foot IK curve has a weight. If it equals 0, clear the offset values.
 	if (GetCurveValue(EnableFootIKCurve) <= 0)
@@ -467,15 +629,27 @@ void UAnonAnimInstance::SetFootOffsets(float DeltaSeconds, FName EnableFootIKCur
 
 	FCollisionQueryParams Params;
 	Params.AddIgnoredActor(Character.Get());
+	// Footsteps reuse this hit for their surface
+	Params.bReturnPhysicalMaterial = true;
 
 	const FVector TraceStart = IKFootFloorLoc + FVector(0.0, 0.0, Config.IK_TraceDistanceAboveFoot);
 	const FVector TraceEnd = IKFootFloorLoc - FVector(0.0, 0.0, Config.IK_TraceDistanceBelowFoot);
 
 	FHitResult HitResult;
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 	World->LineTraceSingleByChannel(HitResult,
 	                                                  TraceStart,
 	                                                  TraceEnd,
 	                                                  ECC_Visibility, Params);
+
+	if (HitResult.bBlockingHit)
+	{
+		FFootGroundHit& GroundHit = FootGroundHits[IKFootBone == IkFootL_BoneName ? 0 : 1];
+		GroundHit.Location = HitResult.ImpactPoint;
+		GroundHit.PhysMaterial = HitResult.PhysMaterial;
+		GroundHit.Component = HitResult.Component;
+		GroundHit.Time = World->GetTimeSeconds();
+	}
 	
 	FRotator TargetRotOffset = FRotator::ZeroRotator;
 	if (Character->GetCharacterMovement()->IsWalkable(HitResult))
@@ -503,6 +677,27 @@ void UAnonAnimInstance::SetFootOffsets(float DeltaSeconds, FName EnableFootIKCur
 	CurRotationOffset = FMath::RInterpTo(CurRotationOffset, TargetRotOffset, DeltaSeconds, 30.f);
 }
 
+bool UAnonAnimInstance::FindFootGroundHit(const FVector& FootLocation, float MaxRadius, float MaxDrop, float MaxAge,
+                                          FFootGroundHit& OutHit) const
+{
+	const UWorld* World = GetWorld();
+	if (!World) return false;
+
+	const double Now = World->GetTimeSeconds();
+	for (const FFootGroundHit& GroundHit : FootGroundHits)
+	{
+		if (GroundHit.Time < 0.0 || Now - GroundHit.Time > MaxAge) continue;
+
+		// Must be right under the foot and within reach of the caller's own trace
+		const FVector Delta = FootLocation - GroundHit.Location;
+		if (Delta.SizeSquared2D() > FMath::Square(MaxRadius) || Delta.Z < -MaxRadius || Delta.Z > MaxDrop) continue;
+
+		OutHit = GroundHit;
+		return true;
+	}
+	return false;
+}
+
 void UAnonAnimInstance::RotateInPlaceCheck()
 {
 	// Step 1: Check if the character should rotate left or right by checking if the Aiming Angle exceeds the threshold.
@@ -659,6 +854,7 @@ void UAnonAnimInstance::UpdateRagdollValues()
 float UAnonAnimInstance::GetAnimCurveClamped(const FName& Name, float Bias, float ClampMin,
                                                      float ClampMax) const
 {
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CurvesRead, 1);
 	return FMath::Clamp(GetCurveValue(Name) + Bias, ClampMin, ClampMax);
 }
 
@@ -784,6 +980,7 @@ float UAnonAnimInstance::CalculateLandPrediction() const
 	FHitResult HitResult;
 	const FCollisionShape CapsuleCollisionShape = FCollisionShape::MakeCapsule(CapsuleComp->GetUnscaledCapsuleRadius(),
 	                                                                           CapsuleComp->GetUnscaledCapsuleHalfHeight());
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 	World->SweepSingleByChannel(HitResult, CapsuleWorldLoc, CapsuleWorldLoc + TraceLength, FQuat::Identity,
 	                                              ECC_Visibility, CapsuleCollisionShape, Params);
 	
@@ -872,8 +1069,9 @@ void UAnonAnimInstance::TurnInPlace(const FRotator& TargetRotation, float PlayRa
 	{
 		return;
 	}
-	PlaySlotAnimationAsDynamicMontage(TargetTurnAsset.Animation, TargetTurnAsset.SlotName, 0.2f, 0.2f,
-	                                  TargetTurnAsset.PlayRate * PlayRateScale, 1, 0.f, StartTime);
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MontagesPlayed, 1);
+	PlayPooledSlotAnimation(TargetTurnAsset.Animation, TargetTurnAsset.SlotName, 0.2f, 0.2f,
+	                        TargetTurnAsset.PlayRate * PlayRateScale, 1, StartTime);
 
 	// Step 4: Scale the rotation amount (gets scaled in AnimGraph) to compensate for turn angle (If Allowed) and play rate.
 	if (TargetTurnAsset.ScaleTurnAngle)
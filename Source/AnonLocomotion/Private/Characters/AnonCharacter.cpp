@@ -7,17 +7,24 @@
 #include "InputActionValue.h"
 #include "InputMappingContext.h"
 #include "MotionWarpingComponent.h"
-#include "Camera/AnonPlayerCameraBehavior.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Characters/AnonAnimInstance.h"
 #include "Components/AnonCharacterMovement.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/TraversalComponent.h"
 #include "Controller/AnonPlayerController.h"
+#include "Engine/DataTable.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Library/CameraTargetAdapter.h"
+#include "Library/LocomotionProfiling.h"
+#include "Library/LocomotionRules.h"
 #include "NavAreas/NavArea_Obstacle.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Subsystems/FootstepFXSubsystem.h"
+#include "Subsystems/LocomotionStateSubsystem.h"
 
-const FName NAME_FP_Camera(TEXT("FP_Camera"));
 const FName NAME_Pelvis(TEXT("Pelvis"));
 const FName NAME_RagdollPose(TEXT("RagdollPose"));
 const FName NAME_RotationAmount(TEXT("RotationAmount"));
@@ -26,6 +33,9 @@ const FName NAME_pelvis(TEXT("pelvis"));
 const FName NAME_root(TEXT("root"));
 const FName NAME_spine_03(TEXT("spine_03"));
 
+/** Degrees, smaller rotation changes are not applied to the actor */
+constexpr float RotationApplyTolerance = 1.e-3f;
+
 AAnonCharacter::AAnonCharacter(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer.SetDefaultSubobjectClass<UAnonCharacterMovement>(CharacterMovementComponentName))
 {
@@ -51,6 +61,9 @@ AAnonCharacter::AAnonCharacter(const FObjectInitializer& ObjectInitializer)
 	// Components
 	MotionWarping = CreateDefaultSubobject<UMotionWarpingComponent>("Motion Warping");
 	Traversal = CreateDefaultSubobject<UTraversalComponent>("Traversal System");
+
+	// Until registered with the world pool, run on the actor-owned block
+	RuntimeState = &FallbackRuntimeState;
 }
 // ==================== Lifecycles ==================== //
 
@@ -64,18 +77,111 @@ void AAnonCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLi
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AAnonCharacter, TargetRagdollLocation);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, ReplicatedCurrentAcceleration, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, ReplicatedControlRotation, COND_SkipOwner);
+	// Every property is push based, setters mark them dirty so they are not compared each net update
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, TargetRagdollLocation, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, DesiredGait, Params);
+
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, ReplicatedLocomotionInput, Params);
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, DesiredStance, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, DesiredRotationMode, Params);
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, RotationMode, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, OverlayState, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, ViewMode, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AAnonCharacter, VisibleMesh, Params);
+}
+
+float AAnonCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer,
+                                     AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	float Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	// Distant idle characters have little new to show, let the moving and nearby ones go first
+	if (bNetIdle && ViewTarget != this &&
+		FVector::DistSquared(ViewPos, GetActorLocation()) > FMath::Square(IdleNetPriorityDistance))
+	{
+		Priority *= IdleNetPriorityScale;
+	}
+
+	return Priority;
+}
+
+void AAnonCharacter::UpdateNetIdleState()
+{
+	// Aim changes reach other players through ReplicatedLocomotionInput, which must not wait for the idle rate either
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (!ReplicatedControlRotation.Equals(NetIdleControlRotation, IdleControlRotationThreshold))
+	{
+		NetIdleControlRotation = ReplicatedControlRotation;
+		LastNetAimTime = Now;
+	}
+	bNetAiming = Now - LastNetAimTime < IdleAimHoldTime;
 
-	DOREPLIFETIME(AAnonCharacter, DesiredGait);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, DesiredStance, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, DesiredRotationMode, COND_SkipOwner);
+	const bool bNewNetIdle = IsNetIdle();
+	if (bNewNetIdle == bNetIdle) return;
 
-	DOREPLIFETIME_CONDITION(AAnonCharacter, RotationMode, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, OverlayState, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, ViewMode, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AAnonCharacter, VisibleMesh, COND_SkipOwner);
+	bNetIdle = bNewNetIdle;
+	if (bNetIdle)
+	{
+		SetNetUpdateFrequency(FMath::Min(IdleNetUpdateFrequency, DefaultNetUpdateFrequency));
+	}
+	else
+	{
+		// Get the first moving frame out right away instead of waiting for the slow idle rate
+		SetNetUpdateFrequency(DefaultNetUpdateFrequency);
+		ForceNetUpdate();
+	}
+}
+
+void AAnonCharacter::UpdateProxyLOD()
+{
+	const bool bNewProxyLOD = ShouldReduceProxy();
+	if (bNewProxyLOD == bProxyLOD) return;
+
+	bProxyLOD = bNewProxyLOD;
+	if (bProxyLOD)
+	{
+		FullFidelityTickInterval = GetActorTickInterval();
+		SetActorTickInterval(FMath::Max(ProxyLODTickInterval, FullFidelityTickInterval));
+	}
+	else
+	{
+		SetActorTickInterval(FullFidelityTickInterval);
+
+		RuntimeState->TargetRotation = GetActorRotation();
+		RuntimeState->AimingRotation = ReplicatedLocomotionInput.GetControlRotation();
+		ProxyLODReturnAlpha = 0.0f;
+	}
+}
+
+bool AAnonCharacter::ShouldReduceProxy() const
+{
+	if (RuntimeState->MovementState == EMovementState::Ragdoll) return false;
+
+	if (!GetMesh()->WasRecentlyRendered(ProxyLODNotRenderedTime)) return true;
+
+	bool bHasView = false;
+	float MinDistSquared = TNumericLimits<float>::Max();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			bHasView = true;
+			MinDistSquared = FMath::Min(MinDistSquared, static_cast<float>(FVector::DistSquared(
+				                            PlayerController->PlayerCameraManager->GetCameraLocation(), GetActorLocation())));
+		}
+	}
+
+	if (!bHasView) return false;
+
+	// Further in to come back than to leave
+	const float Distance = bProxyLOD ? ProxyLODDistance - ProxyLODHysteresis : ProxyLODDistance;
+	return MinDistSquared > FMath::Square(Distance);
 }
 
 void AAnonCharacter::PossessedBy(AController* NewController)
@@ -112,33 +218,42 @@ void AAnonCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 
 void AAnonCharacter::BeginPlay()
 {
+	RegisterRuntimeState();
+	
 	Super::BeginPlay();
 
-	// If we're in networked game, disable curved movement
+	// Curve movement predicts in networked games too (baked, see UAnonCharacterMovement), only roll steering doesn't
 	bEnableNetworkOptimizations = !IsNetMode(NM_Standalone);
 
 	// Make sure the mesh and animbp update after the CharacterBP to ensure it gets the most recent values.
 	GetMesh()->AddTickPrerequisiteActor(this);
 
+	// Nothing is rendered on a dedicated server, montages are enough for root motion and the rotation curves
+	if (bServerLiteAnimation && UKismetSystemLibrary::IsDedicatedServer(GetWorld()))
+	{
+		bServerLiteAnimationActive = true;
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+	}
+
 	// Set the Movement Model
 	SetMovementModel();
 
 	// Force update states to use the initial desired values.
 	ForceUpdateCharacterState();
 
-	if (Stance == EStance::Standing)
+	if (RuntimeState->Stance == EStance::Standing)
 	{
 		UnCrouch();
 	}
-	else if (Stance == EStance::Crouching)
+	else if (RuntimeState->Stance == EStance::Crouching)
 	{
 		Crouch();
 	}
 
 	// Set default rotation values.
-	TargetRotation = GetActorRotation();
-	LastVelocityRotation = TargetRotation;
-	LastMovementInputRotation = TargetRotation;
+	RuntimeState->TargetRotation = GetActorRotation();
+	RuntimeState->LastVelocityRotation = RuntimeState->TargetRotation;
+	RuntimeState->LastMovementInputRotation = RuntimeState->TargetRotation;
 
 	if (GetMesh()->GetAnimInstance() && GetLocalRole() == ROLE_SimulatedProxy)
 	{
@@ -146,35 +261,142 @@ void AAnonCharacter::BeginPlay()
 	}
 
 	AnonCharacterMovement->SetMovementSettings(GetTargetMovementSettings());
+
+	// Not created on dedicated servers
+	if (UFootstepFXSubsystem* FootstepFX = GetWorld()->GetSubsystem<UFootstepFXSubsystem>())
+	{
+		for (const UDataTable* Table : FootstepTables)
+		{
+			FootstepFX->RegisterTable(Table);
+		}
+	}
+
+	DefaultNetUpdateFrequency = GetNetUpdateFrequency();
+}
+
+void AAnonCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	UnregisterRuntimeState();
+}
+
+void AAnonCharacter::RegisterRuntimeState()
+{
+	if (RuntimeStateHandle.IsValid()) return;
+
+	ULocomotionStateSubsystem* StateSubsystem = GetWorld()->GetSubsystem<ULocomotionStateSubsystem>();
+	if (!StateSubsystem) return;
+
+	RuntimeStateHandle = StateSubsystem->Acquire(FallbackRuntimeState, this);
+	RuntimeState = &StateSubsystem->Get(RuntimeStateHandle);
+}
+
+void AAnonCharacter::UnregisterRuntimeState()
+{
+	if (!RuntimeStateHandle.IsValid()) return;
+
+	// Keep the last known values around for anything still querying this actor after EndPlay
+	FallbackRuntimeState = *RuntimeState;
+	RuntimeState = &FallbackRuntimeState;
+
+	if (ULocomotionStateSubsystem* StateSubsystem = GetWorld()->GetSubsystem<ULocomotionStateSubsystem>())
+	{
+		StateSubsystem->Release(RuntimeStateHandle);
+	}
+	RuntimeStateHandle.Invalidate();
 }
 
 void AAnonCharacter::Tick(float DeltaTime)
 {
+	LOCOMOTION_BENCHMARK_SCOPE(CharacterTick);
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_CharacterTick);
+
+	// Input of this frame was already dispatched by the controller
+	InputRecorder.EndFrame(DeltaTime, GetControlRotation());
+
 	Super::Tick(DeltaTime);
 
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		UpdateProxyLOD();
+	}
+
 	// Set required values
 	SetEssentialValues(DeltaTime);
 
-	if (MovementState == EMovementState::Grounded)
+	if (bProxyLOD && RuntimeState->MovementState != EMovementState::Ragdoll)
+	{
+		// Reduced fidelity: no gait or rotation logic, the replicated rotation is used as is (smoothed by the movement
+		// component) and becomes the starting point once full fidelity returns
+		RuntimeState->TargetRotation = GetActorRotation();
+		RuntimeState->PreviousVelocity = GetVelocity();
+		RuntimeState->PreviousAimYaw = RuntimeState->AimingRotation.Yaw;
+		return;
+	}
+
+	const FRotator ReplicatedRotation = GetActorRotation();
+
+	if (HasAuthority())
+	{
+		UpdateNetIdleState();
+	}
+
+	if (RuntimeState->MovementState == EMovementState::Grounded)
 	{
 		UpdateCharacterMovement();
-		UpdateGroundedRotation(DeltaTime);
+
+		// Turn in place is normally started by the anim graph update, which doesn't run in server lite mode
+		if (IsServerLiteAnimating())
+		{
+			if (UAnonAnimInstance* AnimInstance = Cast<UAnonAnimInstance>(GetMesh()->GetAnimInstance()))
+			{
+				AnimInstance->UpdateServerLite(DeltaTime);
+			}
+		}
 	}
-	else if (MovementState == EMovementState::InAir)
+
 	{
-		UpdateInAirRotation(DeltaTime);
+		// However often the rotation below moves the capsule, attached components and overlaps update once at the end
+		FScopedMovementUpdate ScopedRotationUpdate(GetCapsuleComponent(), EScopedUpdate::DeferredUpdates);
 
-		// This one is try to reach any obstacle to get climb/mantle
-		Traversal->TriggerTraversalAction();
+		if (RuntimeState->MovementState == EMovementState::Grounded)
+		{
+			UpdateGroundedRotation(DeltaTime);
+		}
+		else if (RuntimeState->MovementState == EMovementState::InAir)
+		{
+			UpdateInAirRotation(DeltaTime);
+		}
+		else if (RuntimeState->MovementState == EMovementState::Ragdoll)
+		{
+			RagdollUpdate(DeltaTime);
+		}
+
+		// Just back from reduced fidelity, ease from the replicated rotation into the computed one instead of popping
+		if (ProxyLODReturnAlpha < 1.0f)
+		{
+			ProxyLODReturnAlpha = ProxyLODReturnBlendTime > 0.0f
+				                      ? FMath::Min(ProxyLODReturnAlpha + DeltaTime / ProxyLODReturnBlendTime, 1.0f)
+				                      : 1.0f;
+			ApplyActorRotation(FMath::Lerp(ReplicatedRotation, GetActorRotation(), ProxyLODReturnAlpha));
+		}
+
+		if (ScopedRotationUpdate.IsTransformDirty())
+		{
+			LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TransformUpdates, 1);
+		}
 	}
-	else if (MovementState == EMovementState::Ragdoll)
+
+	if (RuntimeState->MovementState == EMovementState::InAir)
 	{
-		RagdollUpdate(DeltaTime);
+		// This one is try to reach any obstacle to get climb/mantle. Traces from the mesh, so after the rotation scope
+		Traversal->TriggerTraversalAction();
 	}
 
 	// Cache values
-	PreviousVelocity = GetVelocity();
-	PreviousAimYaw = AimingRotation.Yaw;
+	RuntimeState->PreviousVelocity = GetVelocity();
+	RuntimeState->PreviousAimYaw = RuntimeState->AimingRotation.Yaw;
 }
 
 // ==================== Ragdoll System ==================== //
@@ -248,6 +470,7 @@ void AAnonCharacter::RagdollStart()
 		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
 	}
 	TargetRagdollLocation = GetMesh()->GetSocketLocation(NAME_Pelvis);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, TargetRagdollLocation, this);
 	ServerRagdollPull = 0;
 
 	// Disable URO
@@ -278,6 +501,8 @@ void AAnonCharacter::RagdollStart()
 
 void AAnonCharacter::RagdollUpdate(float DeltaTime)
 {
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_RagdollUpdate);
+
 	GetMesh()->bOnlyAllowAutonomousTickPose = false;
 
 	// Set the Last Ragdoll Velocity.
@@ -306,6 +531,7 @@ void AAnonCharacter::SetActorLocationDuringRagdoll(float DeltaTime)
 	{
 		// Set the pelvis as the target location.
 		TargetRagdollLocation = GetMesh()->GetSocketLocation(NAME_Pelvis);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, TargetRagdollLocation, this);
 		if (!HasAuthority())
 		{
 			Server_SetMeshLocationDuringRagdoll(TargetRagdollLocation);
@@ -337,6 +563,7 @@ void AAnonCharacter::SetActorLocationDuringRagdoll(float DeltaTime)
 	Params.AddIgnoredActor(this);
 
 	FHitResult HitResult;
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 	World->LineTraceSingleByChannel(HitResult, TargetRagdollLocation, TraceVect,
 	                                                  ECC_Visibility, Params);
 	
@@ -410,6 +637,7 @@ void AAnonCharacter::RagdollEnd()
 		GetCharacterMovement()->SetMovementMode(MOVE_Walking);
 		if (GetMesh()->GetAnimInstance())
 		{
+			LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MontagesPlayed, 1);
 			GetMesh()->GetAnimInstance()->Montage_Play(GetGetUpAnimation(bRagdollFaceUp), 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
 		}
 	}
@@ -458,17 +686,18 @@ void AAnonCharacter::ReplicatedRagdollEnd()
 void AAnonCharacter::Server_SetMeshLocationDuringRagdoll_Implementation(FVector MeshLocation)
 {
 	TargetRagdollLocation = MeshLocation;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, TargetRagdollLocation, this);
 }
 
 // ==================== Character States ==================== //
 
 void AAnonCharacter::SetMovementState(const EMovementState NewState, bool bForce)
 {
-	if (bForce || MovementState != NewState)
+	if (bForce || RuntimeState->MovementState != NewState)
 	{
-		PrevMovementState = MovementState;
-		MovementState = NewState;
-		OnMovementStateChanged(PrevMovementState);
+		RuntimeState->PrevMovementState = RuntimeState->MovementState;
+		RuntimeState->MovementState = NewState;
+		OnMovementStateChanged(RuntimeState->PrevMovementState);
 	}
 }
 
@@ -484,10 +713,10 @@ void AAnonCharacter::SetMovementAction(const EMovementAction NewAction, bool bFo
 
 void AAnonCharacter::SetStance(const EStance NewStance, bool bForce)
 {
-	if (bForce || Stance != NewStance)
+	if (bForce || RuntimeState->Stance != NewStance)
 	{
-		const EStance Prev = Stance;
-		Stance = NewStance;
+		const EStance Prev = RuntimeState->Stance;
+		RuntimeState->Stance = NewStance;
 		OnStanceChanged(Prev);
 	}
 }
@@ -495,28 +724,24 @@ void AAnonCharacter::SetStance(const EStance NewStance, bool bForce)
 void AAnonCharacter::SetDesiredStance(EStance NewStance)
 {
 	DesiredStance = NewStance;
-	if (GetLocalRole() == ROLE_AutonomousProxy)
-	{
-		Server_SetDesiredStance(NewStance);
-	}
-}
-
-void AAnonCharacter::Server_SetDesiredStance_Implementation(EStance NewStance)
-{
-	SetDesiredStance(NewStance);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, DesiredStance, this);
 }
 
 void AAnonCharacter::SetOverlayOverrideState(int32 NewState)
 {
-	OverlayOverrideState = NewState;
+	if (OverlayOverrideState != NewState)
+	{
+		OverlayOverrideState = NewState;
+		MarkStateDirty();
+	}
 }
 
 void AAnonCharacter::SetGait(const EGait NewGait, bool bForce)
 {
-	if (bForce || Gait != NewGait)
+	if (bForce || RuntimeState->Gait != NewGait)
 	{
-		const EGait Prev = Gait;
-		Gait = NewGait;
+		const EGait Prev = RuntimeState->Gait;
+		RuntimeState->Gait = NewGait;
 		OnGaitChanged(Prev);
 	}
 }
@@ -524,29 +749,13 @@ void AAnonCharacter::SetGait(const EGait NewGait, bool bForce)
 void AAnonCharacter::SetDesiredGait(const EGait NewGait)
 {
 	DesiredGait = NewGait;
-	if (GetLocalRole() == ROLE_AutonomousProxy)
-	{
-		Server_SetDesiredGait(NewGait);
-	}
-}
-
-void AAnonCharacter::Server_SetDesiredGait_Implementation(EGait NewGait)
-{
-	SetDesiredGait(NewGait);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, DesiredGait, this);
 }
 
 void AAnonCharacter::SetDesiredRotationMode(ERotationMode NewRotMode)
 {
 	DesiredRotationMode = NewRotMode;
-	if (GetLocalRole() == ROLE_AutonomousProxy)
-	{
-		Server_SetDesiredRotationMode(NewRotMode);
-	}
-}
-
-void AAnonCharacter::Server_SetDesiredRotationMode_Implementation(ERotationMode NewRotMode)
-{
-	SetDesiredRotationMode(NewRotMode);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, DesiredRotationMode, this);
 }
 
 void AAnonCharacter::SetRotationMode(const ERotationMode NewRotationMode, bool bForce)
@@ -555,63 +764,89 @@ void AAnonCharacter::SetRotationMode(const ERotationMode NewRotationMode, bool b
 	{
 		const ERotationMode Prev = RotationMode;
 		RotationMode = NewRotationMode;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, RotationMode, this);
 		OnRotationModeChanged(Prev);
-
-		if (GetLocalRole() == ROLE_AutonomousProxy)
-		{
-			Server_SetRotationMode(NewRotationMode, bForce);
-		}
 	}
 }
 
-void AAnonCharacter::Server_SetRotationMode_Implementation(ERotationMode NewRotationMode, bool bForce)
-{
-	SetRotationMode(NewRotationMode, bForce);
-}
-
 void AAnonCharacter::SetViewMode(const EViewMode NewViewMode, bool bForce)
 {
 	if (bForce || ViewMode != NewViewMode)
 	{
 		const EViewMode Prev = ViewMode;
 		ViewMode = NewViewMode;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, ViewMode, this);
 		OnViewModeChanged(Prev);
-
-		if (GetLocalRole() == ROLE_AutonomousProxy)
-		{
-			Server_SetViewMode(NewViewMode, bForce);
-		}
 	}
 }
 
-void AAnonCharacter::Server_SetViewMode_Implementation(EViewMode NewViewMode, bool bForce)
-{
-	SetViewMode(NewViewMode, bForce);
-}
-
 void AAnonCharacter::SetOverlayState(const EOverlayState NewState, bool bForce)
 {
 	if (bForce || OverlayState != NewState)
 	{
 		const EOverlayState Prev = OverlayState;
 		OverlayState = NewState;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, OverlayState, this);
 		OnOverlayStateChanged(Prev);
-
-		if (GetLocalRole() == ROLE_AutonomousProxy)
-		{
-			Server_SetOverlayState(NewState, bForce);
-		}
 	}
 }
 
 void AAnonCharacter::SetGroundedEntryState(EGroundedEntryState NewState)
 {
-	GroundedEntryState = NewState;
+	if (GroundedEntryState != NewState)
+	{
+		GroundedEntryState = NewState;
+		MarkStateDirty();
+	}
 }
 
-void AAnonCharacter::Server_SetOverlayState_Implementation(EOverlayState NewState, bool bForce)
+FLocomotionIntent AAnonCharacter::GetLocomotionIntent() const
 {
-	SetOverlayState(NewState, bForce);
+	FLocomotionIntent Intent;
+	Intent.DesiredStance = DesiredStance;
+	Intent.DesiredGait = DesiredGait;
+	Intent.RotationMode = RotationMode;
+	Intent.DesiredRotationMode = DesiredRotationMode;
+	Intent.ViewMode = ViewMode;
+	Intent.OverlayState = OverlayState;
+	return Intent;
+}
+
+void AAnonCharacter::ApplyLocomotionIntent(const FLocomotionIntent& Intent)
+{
+	// Every move repeats the intent. Rotation/view mode and overlay state skip the owner when replicated, so the client
+	// never learns about server side changes of them and would keep sending the old values back
+	if (Intent == LastReceivedIntent) return;
+
+	const FLocomotionIntent Previous = LastReceivedIntent;
+	LastReceivedIntent = Intent;
+
+	if (Intent.DesiredStance != Previous.DesiredStance && DesiredStance != Intent.DesiredStance)
+	{
+		SetDesiredStance(Intent.DesiredStance);
+	}
+	if (Intent.DesiredGait != Previous.DesiredGait && DesiredGait != Intent.DesiredGait)
+	{
+		SetDesiredGait(Intent.DesiredGait);
+	}
+	if (Intent.DesiredRotationMode != Previous.DesiredRotationMode && DesiredRotationMode != Intent.DesiredRotationMode)
+	{
+		SetDesiredRotationMode(Intent.DesiredRotationMode);
+	}
+
+	// View mode first, its change hook may reset the rotation mode which the client already resolved for us
+	if (Intent.ViewMode != Previous.ViewMode)
+	{
+		SetViewMode(Intent.ViewMode);
+	}
+	if (Intent.RotationMode != Previous.RotationMode)
+	{
+		SetRotationMode(Intent.RotationMode);
+	}
+	if (Intent.OverlayState != Previous.OverlayState)
+	{
+		SetOverlayState(Intent.OverlayState);
+	}
 }
 
 // ==================== Jumping ==================== //
@@ -624,13 +859,13 @@ void AAnonCharacter::EventOnLanded()
 	{
 		ReplicatedRagdollStart();
 	}
-	else if (bBreakfallOnLand && bHasMovementInput && VelZ >= BreakfallOnLandVelocity)
+	else if (bBreakfallOnLand && RuntimeState->bHasMovementInput && VelZ >= BreakfallOnLandVelocity)
 	{
 		OnBreakfall();
 	}
 	else
 	{
-		GetCharacterMovement()->BrakingFrictionFactor = bHasMovementInput ? 0.5f : 3.0f;
+		GetCharacterMovement()->BrakingFrictionFactor = RuntimeState->bHasMovementInput ? 0.5f : 3.0f;
 
 		// After 0.5 secs, reset braking friction factor to zero
 		GetWorldTimerManager().SetTimer(OnLandedFrictionResetTimer, this,
@@ -649,7 +884,7 @@ void AAnonCharacter::Multicast_OnLanded_Implementation()
 void AAnonCharacter::EventOnJumped()
 {
 	// Set the new In Air Rotation to the velocity rotation if speed is greater than 100.
-	InAirRotation = Speed > 100.0f ? LastVelocityRotation : GetActorRotation();
+	InAirRotation = RuntimeState->Speed > 100.0f ? RuntimeState->LastVelocityRotation : GetActorRotation();
 
 	OnJumpedDelegate.Broadcast();
 }
@@ -701,6 +936,7 @@ void AAnonCharacter::Server_PlayMontage_Implementation(UAnimMontage* Montage, fl
 {
 	if (GetMesh()->GetAnimInstance())
 	{
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MontagesPlayed, 1);
 		GetMesh()->GetAnimInstance()->Montage_Play(Montage, PlayRate);
 	}
 
@@ -712,6 +948,7 @@ void AAnonCharacter::Multicast_PlayMontage_Implementation(UAnimMontage* Montage,
 {
 	if (GetMesh()->GetAnimInstance() && !IsLocallyControlled())
 	{
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MontagesPlayed, 1);
 		GetMesh()->GetAnimInstance()->Montage_Play(Montage, PlayRate);
 	}
 }
@@ -721,47 +958,107 @@ void AAnonCharacter::Replicated_PlayMontage(UAnimMontage* Montage, float PlayRat
 	// Roll: Simply play a Root Motion Montage.
 	if (GetMesh()->GetAnimInstance())
 	{
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MontagesPlayed, 1);
 		GetMesh()->GetAnimInstance()->Montage_Play(Montage, PlayRate);
 	}
 
 	Server_PlayMontage(Montage, PlayRate);
 }
 
+void AAnonCharacter::RegisterEarlyBlendOut(const FEarlyBlendOutCondition& Condition)
+{
+	// Montage_Stop(nullptr) would stop every montage of the anim instance
+	if (!Condition.Montage.IsValid()) return;
+
+	EarlyBlendOuts.Add(Condition);
+	UpdateEarlyBlendOuts();
+}
+
+void AAnonCharacter::UnregisterEarlyBlendOut(const UObject* Source, const UAnimMontage* Montage)
+{
+	for (int32 i = EarlyBlendOuts.Num() - 1; i >= 0; --i)
+	{
+		if (EarlyBlendOuts[i].Source == Source && EarlyBlendOuts[i].Montage.Get() == Montage)
+		{
+			EarlyBlendOuts.RemoveAtSwap(i, 1, EAllowShrinking::No);
+			return;
+		}
+	}
+}
+
+void AAnonCharacter::UpdateEarlyBlendOuts()
+{
+	if (EarlyBlendOuts.IsEmpty()) return;
+
+	// Montage_Stop ends the notify window, which unregisters it again. Take the windows out before stopping anything
+	TArray<FEarlyBlendOutCondition, TInlineAllocator<2>> ToStop;
+	for (int32 i = EarlyBlendOuts.Num() - 1; i >= 0; --i)
+	{
+		const FEarlyBlendOutCondition& Condition = EarlyBlendOuts[i];
+		const UAnimInstance* AnimInstance = Condition.AnimInstance.Get();
+		const UAnimMontage* Montage = Condition.Montage.Get();
+
+		// Windows whose montage ended or got interrupted without reaching NotifyEnd
+		if (!AnimInstance || !Montage || !AnimInstance->Montage_IsActive(Montage))
+		{
+			EarlyBlendOuts.RemoveAtSwap(i, 1, EAllowShrinking::No);
+		}
+		else if ((Condition.bCheckMovementState && RuntimeState->MovementState == Condition.MovementStateEquals)
+			|| (Condition.bCheckStance && RuntimeState->Stance == Condition.StanceEquals)
+			|| (Condition.bCheckMovementInput && RuntimeState->bHasMovementInput))
+		{
+			ToStop.Add(Condition);
+			EarlyBlendOuts.RemoveAtSwap(i, 1, EAllowShrinking::No);
+		}
+	}
+
+	for (const FEarlyBlendOutCondition& Condition : ToStop)
+	{
+		UAnimInstance* AnimInstance = Condition.AnimInstance.Get();
+		const UAnimMontage* Montage = Condition.Montage.Get();
+		if (AnimInstance && Montage)
+		{
+			AnimInstance->Montage_Stop(Condition.BlendOutTime, Montage);
+		}
+	}
+}
+
 // ==================== Rotation System ==================== //
 
 void AAnonCharacter::SmoothCharacterRotation(const FRotator& Target, float TargetInterpSpeed, float ActorInterpSpeed,
 											 float DeltaTime)
 {
-	// Interpolate the Target Rotation for extra smooth rotation behavior
-	TargetRotation =
-		FMath::RInterpConstantTo(TargetRotation, Target, DeltaTime, TargetInterpSpeed);
-	SetActorRotation(
-		FMath::RInterpTo(GetActorRotation(), TargetRotation, DeltaTime, ActorInterpSpeed));
+	ApplyActorRotation(FLocomotionRules::SmoothRotation(GetActorRotation(), RuntimeState->TargetRotation, Target,
+	                                                    TargetInterpSpeed, ActorInterpSpeed, DeltaTime));
 }
 
-float AAnonCharacter::CalculateGroundedRotationRate() const
+void AAnonCharacter::ApplyActorRotation(const FRotator& NewRotation)
 {
-	// Calculate the rotation rate by using the current Rotation Rate Curve in the Movement Settings.
-	// Using the curve in conjunction with the mapped speed gives you a high level of control over the rotation
-	// rates for each speed. Increase the speed if the camera is rotating quickly for more responsive rotation.
+	if (GetActorRotation().Equals(NewRotation, RotationApplyTolerance))
+	{
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_RotationSkipped, 1);
+		return;
+	}
+
+	SetActorRotation(NewRotation);
+}
 
-	const float MappedSpeedVal = AnonCharacterMovement->GetMappedSpeed();
-	const float CurveVal =
-		AnonCharacterMovement->CurrentMovementSettings.RotationRateCurve->GetFloatValue(MappedSpeedVal);
-	const float ClampedAimYawRate = FMath::GetMappedRangeValueClamped<float, float>({0.0f, 300.0f}, {1.0f, 3.0f}, AimYawRate);
-	return CurveVal * ClampedAimYawRate;
+float AAnonCharacter::CalculateGroundedRotationRate() const
+{
+	return FLocomotionRules::GetGroundedRotationRate(AnonCharacterMovement->CurrentMovementSettings,
+	                                                 AnonCharacterMovement->GetMappedSpeed(), RuntimeState->AimYawRate);
 }
 
 void AAnonCharacter::LimitRotation(float AimYawMin, float AimYawMax, float InterpSpeed, float DeltaTime)
 {
 	// Prevent the character from rotating past a certain angle.
-	FRotator Delta = AimingRotation - GetActorRotation();
+	FRotator Delta = RuntimeState->AimingRotation - GetActorRotation();
 	Delta.Normalize();
 	const float RangeVal = Delta.Yaw;
 
 	if (RangeVal < AimYawMin || RangeVal > AimYawMax)
 	{
-		const float ControlRotYaw = AimingRotation.Yaw;
+		const float ControlRotYaw = RuntimeState->AimingRotation.Yaw;
 		const float TargetYaw = ControlRotYaw + (RangeVal > 0.0f ? AimYawMin : AimYawMax);
 		SmoothCharacterRotation({0.0f, TargetYaw, 0.0f}, 0.0f, InterpSpeed, DeltaTime);
 	}
@@ -769,8 +1066,17 @@ void AAnonCharacter::LimitRotation(float AimYawMin, float AimYawMax, float Inter
 
 void AAnonCharacter::SetActorLocationAndTargetRotation(const FVector& NewLocation, const FRotator& NewRotation)
 {
-	SetActorLocationAndRotation(NewLocation, NewRotation);
-	TargetRotation = NewRotation;
+	// A ragdoll at rest keeps asking for the same transform
+	if (GetActorLocation().Equals(NewLocation, UE_KINDA_SMALL_NUMBER) &&
+		GetActorRotation().Equals(NewRotation, RotationApplyTolerance))
+	{
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_RotationSkipped, 1);
+	}
+	else
+	{
+		SetActorLocationAndRotation(NewLocation, NewRotation);
+	}
+	RuntimeState->TargetRotation = NewRotation;
 }
 
 // ==================== Breakfall System ==================== //
@@ -784,126 +1090,39 @@ void AAnonCharacter::OnBreakfall()
 
 FMovementSettings AAnonCharacter::GetTargetMovementSettings() const
 {
-	if (RotationMode == ERotationMode::VelocityDirection)
-	{
-		if (Stance == EStance::Standing)
-		{
-			return MovementData.VelocityDirection.Standing;
-		}
-		if (Stance == EStance::Crouching)
-		{
-			return MovementData.VelocityDirection.Crouching;
-		}
-	}
-	else if (RotationMode == ERotationMode::LookingDirection)
-	{
-		if (Stance == EStance::Standing)
-		{
-			return MovementData.LookingDirection.Standing;
-		}
-		if (Stance == EStance::Crouching)
-		{
-			return MovementData.LookingDirection.Crouching;
-		}
-	}
-	else if (RotationMode == ERotationMode::Aiming)
-	{
-		if (Stance == EStance::Standing)
-		{
-			return MovementData.Aiming.Standing;
-		}
-		if (Stance == EStance::Crouching)
-		{
-			return MovementData.Aiming.Crouching;
-		}
-	}
-
-	// Default to velocity dir standing
-	return MovementData.VelocityDirection.Standing;
+	return FLocomotionRules::SelectMovementSettings(MovementData, RotationMode, RuntimeState->Stance);
 }
 
 EGait AAnonCharacter::GetAllowedGait() const
 {
-	// Calculate the Allowed Gait. This represents the maximum Gait the character is currently allowed to be in,
-	// and can be determined by the desired gait, the rotation mode, the stance, etc. For example,
-	// if you wanted to force the character into a walking state while indoors, this could be done here.
-
-	if (Stance == EStance::Standing)
-	{
-		if (RotationMode != ERotationMode::Aiming)
-		{
-			if (DesiredGait == EGait::Sprinting)
-			{
-				return CanSprint() ? EGait::Sprinting : EGait::Running;
-			}
-			return DesiredGait;
-		}
-	}
-
-	// Crouching stance & Aiming rot mode has same behaviour
+	// CanSprint only matters while sprinting is desired
+	return FLocomotionRules::GetAllowedGait(RuntimeState->Stance, RotationMode, DesiredGait,
+	                                        DesiredGait == EGait::Sprinting && CanSprint());
+}
 
-	if (DesiredGait == EGait::Sprinting)
-	{
-		return EGait::Running;
-	}
+EGait AAnonCharacter::GetMaxAllowedGaitForMove() const
+{
+	// Same inputs the client's GetAllowedGait had: the acceleration of the previous move, before this one is simulated
+	const FVector Acceleration = GetCharacterMovement()->GetCurrentAcceleration();
+	const float MaxAcceleration = GetCharacterMovement()->GetMaxAcceleration();
+	const float InputAmount = MaxAcceleration > 0.0f ? Acceleration.Size() / MaxAcceleration : 0.0f;
 
-	return DesiredGait;
+	const bool bCanSprint = DesiredGait == EGait::Sprinting
+		&& FLocomotionRules::CanSprint(RotationMode, InputAmount > 0.0f, InputAmount,
+		                               Acceleration.ToOrientationRotator(), GetControlRotation());
+	return FLocomotionRules::GetAllowedGait(RuntimeState->Stance, RotationMode, DesiredGait, bCanSprint);
 }
 
 EGait AAnonCharacter::GetActualGait(EGait AllowedGait) const
 {
-	// Get the Actual Gait. This is calculated by the actual movement of the character,  and so it can be different
-	// from the desired gait or allowed gait. For instance, if the Allowed Gait becomes walking,
-	// the Actual gait will still be running until the character decelerates to the walking speed.
-
-	const float LocWalkSpeed = AnonCharacterMovement->CurrentMovementSettings.WalkSpeed;
-	const float LocRunSpeed = AnonCharacterMovement->CurrentMovementSettings.RunSpeed;
-
-	if (Speed > LocRunSpeed + 10.0f)
-	{
-		if (AllowedGait == EGait::Sprinting)
-		{
-			return EGait::Sprinting;
-		}
-		return EGait::Running;
-	}
-
-	if (Speed >= LocWalkSpeed + 10.0f)
-	{
-		return EGait::Running;
-	}
-
-	return EGait::Walking;
+	return FLocomotionRules::GetActualGait(RuntimeState->Speed, AnonCharacterMovement->CurrentMovementSettings,
+	                                       AllowedGait);
 }
 
 bool AAnonCharacter::CanSprint() const
 {
-	// Determine if the character is currently able to sprint based on the Rotation mode and current acceleration
-	// (input) rotation. If the character is in the Looking Rotation mode, only allow sprinting if there is full
-	// movement input, and it is faced forward relative to the camera + or - 50 degrees.
-
-	if (!bHasMovementInput || RotationMode == ERotationMode::Aiming)
-	{
-		return false;
-	}
-
-	const bool bValidInputAmount = MovementInputAmount > 0.9f;
-
-	if (RotationMode == ERotationMode::VelocityDirection)
-	{
-		return bValidInputAmount;
-	}
-
-	if (RotationMode == ERotationMode::LookingDirection)
-	{
-		const FRotator AccRot = ReplicatedCurrentAcceleration.ToOrientationRotator();
-		FRotator Delta = AccRot - AimingRotation;
-		Delta.Normalize();
-
-		return bValidInputAmount && FMath::Abs(Delta.Yaw) < 50.0f;
-	}
-
-	return false;
+	return FLocomotionRules::CanSprint(RotationMode, RuntimeState->bHasMovementInput, RuntimeState->MovementInputAmount,
+	                                   ReplicatedCurrentAcceleration.ToOrientationRotator(), RuntimeState->AimingRotation);
 }
 
 void AAnonCharacter::SetMovementModel()
@@ -946,12 +1165,33 @@ UAnimMontage* AAnonCharacter::GetRollAnimation()
 
 float AAnonCharacter::GetAnimCurveValue(FName CurveName) const
 {
-	if (GetMesh()->GetAnimInstance())
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (!AnimInstance) return 0.0f;
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CurvesRead, 1);
+	if (!IsServerLiteAnimating())
+	{
+		return AnimInstance->GetCurveValue(CurveName);
+	}
+
+	// Comes from the looping locomotion cycles rather than a montage, rebuilt from the graph's own inputs
+	if (CurveName == NAME_YawOffset)
 	{
-		return GetMesh()->GetAnimInstance()->GetCurveValue(CurveName);
+		const UAnonAnimInstance* AnonAnimInstance = Cast<UAnonAnimInstance>(AnimInstance);
+		return AnonAnimInstance ? AnonAnimInstance->GetServerLiteYawOffset() : 0.0f;
 	}
 
-	return 0.0f;
+	float Value = MontageCurves.GetCurveValue(*AnimInstance, CurveName);
+
+	// The anim graph scales the turn in place rotation to the actual turn angle and play rate, do the same here
+	if (CurveName == NAME_RotationAmount)
+	{
+		if (const UAnonAnimInstance* AnonAnimInstance = Cast<UAnonAnimInstance>(AnimInstance))
+		{
+			Value *= AnonAnimInstance->GetTurnInPlaceRotationScale();
+		}
+	}
+	return Value;
 }
 
 void AAnonCharacter::SetVisibleMesh(USkeletalMesh* NewVisibleMesh)
@@ -960,6 +1200,7 @@ void AAnonCharacter::SetVisibleMesh(USkeletalMesh* NewVisibleMesh)
 	{
 		const USkeletalMesh* Prev = VisibleMesh;
 		VisibleMesh = NewVisibleMesh;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, VisibleMesh, this);
 		OnVisibleMeshChanged(Prev);
 
 		if (GetLocalRole() != ROLE_Authority)
@@ -979,15 +1220,12 @@ void AAnonCharacter::Server_SetVisibleMesh_Implementation(USkeletalMesh* NewVisi
 void AAnonCharacter::SetRightShoulder(bool bNewRightShoulder)
 {
 	bRightShoulder = bNewRightShoulder;
-	if (CameraBehavior)
-	{
-		CameraBehavior->bRightShoulder = bRightShoulder;
-	}
+	MarkStateDirty();
 }
 
 ECollisionChannel AAnonCharacter::GetThirdPersonTraceParams(FVector& TraceOrigin, float& TraceRadius)
 {
-	const FName CameraSocketName = bRightShoulder ? TEXT("TP_CameraTrace_R") : TEXT("TP_CameraTrace_L");
+	const FName CameraSocketName = bRightShoulder ? FCameraTargetSockets::TraceRight : FCameraTargetSockets::TraceLeft;
 	TraceOrigin = GetMesh()->GetSocketLocation(CameraSocketName);
 	TraceRadius = 15.0f;
 	
@@ -997,35 +1235,51 @@ ECollisionChannel AAnonCharacter::GetThirdPersonTraceParams(FVector& TraceOrigin
 FTransform AAnonCharacter::GetThirdPersonPivotTarget()
 {
 	return FTransform(GetActorRotation(),
-					  (GetMesh()->GetSocketLocation(TEXT("Head")) + GetMesh()->GetSocketLocation(TEXT("root"))) / 2.0f,
+					  (GetMesh()->GetSocketLocation(FCameraTargetSockets::Head) +
+					   GetMesh()->GetSocketLocation(FCameraTargetSockets::Root)) / 2.0f,
 					  FVector::OneVector);
 }
 
 FVector AAnonCharacter::GetFirstPersonCameraTarget()
 {
-	return GetMesh()->GetSocketLocation(TEXT("FP_Camera"));
+	return GetMesh()->GetSocketLocation(FCameraTargetSockets::FirstPersonCamera);
 }
 
 // ==================== Essential Information Getters/Setters ==================== //
 
 void AAnonCharacter::SetEssentialValues(float DeltaTime)
 {
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_SetEssentialValues);
+
 	if (GetLocalRole() != ROLE_SimulatedProxy)
 	{
 		ReplicatedCurrentAcceleration = GetCharacterMovement()->GetCurrentAcceleration();
 		ReplicatedControlRotation = GetControlRotation();
-		EasedMaxAcceleration = GetCharacterMovement()->GetMaxAcceleration();
+		RuntimeState->EasedMaxAcceleration = GetCharacterMovement()->GetMaxAcceleration();
+
+		if (HasAuthority())
+		{
+			if (ReplicatedLocomotionInput.Update(ReplicatedCurrentAcceleration, RuntimeState->EasedMaxAcceleration,
+			                                     ReplicatedControlRotation, ReplicatedInputAmountThreshold,
+			                                     ReplicatedRotationThreshold))
+			{
+				MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, ReplicatedLocomotionInput, this);
+			}
+		}
 	}
 	else
 	{
-		EasedMaxAcceleration = GetCharacterMovement()->GetMaxAcceleration() != 0
+		RuntimeState->EasedMaxAcceleration = GetCharacterMovement()->GetMaxAcceleration() != 0
 			                       ? GetCharacterMovement()->GetMaxAcceleration()
-			                       : EasedMaxAcceleration / 2;
+			                       : RuntimeState->EasedMaxAcceleration / 2;
+
+		ReplicatedCurrentAcceleration = ReplicatedLocomotionInput.GetAcceleration(RuntimeState->EasedMaxAcceleration);
+		ReplicatedControlRotation = ReplicatedLocomotionInput.GetControlRotation();
 	}
 
 	// Interp AimingRotation to current control rotation for smooth character rotation movement. Decrease InterpSpeed
 	// for slower but smoother movement.
-	AimingRotation = FMath::RInterpTo(AimingRotation, ReplicatedControlRotation, DeltaTime, 30);
+	RuntimeState->AimingRotation = FMath::RInterpTo(RuntimeState->AimingRotation, ReplicatedControlRotation, DeltaTime, 30);
 
 	// These values represent how the capsule is moving as well as how it wants to move, and therefore are essential
 	// for any data driven animation system. They are also used throughout the system for various functions,
@@ -1034,34 +1288,40 @@ void AAnonCharacter::SetEssentialValues(float DeltaTime)
 	const FVector CurrentVel = GetVelocity();
 
 	// Set the amount of Acceleration.
-	const FVector NewAcceleration = (CurrentVel - PreviousVelocity) / DeltaTime;
-	Acceleration = NewAcceleration.IsNearlyZero() || IsLocallyControlled() ? NewAcceleration : Acceleration / 2;
+	const FVector NewAcceleration = (CurrentVel - RuntimeState->PreviousVelocity) / DeltaTime;
+	RuntimeState->Acceleration = NewAcceleration.IsNearlyZero() || IsLocallyControlled() ? NewAcceleration : RuntimeState->Acceleration / 2;
 
 	// Determine if the character is moving by getting its speed. The Speed equals the length of the horizontal (x y)
 	// velocity, so it does not take vertical movement into account. If the character is moving, update the last
 	// velocity rotation. This value is saved because it might be useful to know the last orientation of movement
 	// even after the character has stopped.
-	Speed = CurrentVel.Size2D();
-	bIsMoving = Speed > 1.0f;
-	if (bIsMoving)
+	RuntimeState->Speed = CurrentVel.Size2D();
+	RuntimeState->bIsMoving = RuntimeState->Speed > 1.0f;
+	if (RuntimeState->bIsMoving)
 	{
-		LastVelocityRotation = CurrentVel.ToOrientationRotator();
+		RuntimeState->LastVelocityRotation = CurrentVel.ToOrientationRotator();
 	}
 
 	// Determine if the character has movement input by getting its movement input amount.
 	// The Movement Input Amount is equal to the current acceleration divided by the max acceleration so that
 	// it has a range of 0-1, 1 being the maximum possible amount of input, and 0 being none.
 	// If the character has movement input, update the Last Movement Input Rotation.
-	MovementInputAmount = ReplicatedCurrentAcceleration.Size() / EasedMaxAcceleration;
-	bHasMovementInput = MovementInputAmount > 0.0f;
-	if (bHasMovementInput)
+	const bool bHadMovementInput = RuntimeState->bHasMovementInput;
+	RuntimeState->MovementInputAmount = ReplicatedCurrentAcceleration.Size() / RuntimeState->EasedMaxAcceleration;
+	RuntimeState->bHasMovementInput = RuntimeState->MovementInputAmount > 0.0f;
+	if (RuntimeState->bHasMovementInput)
 	{
-		LastMovementInputRotation = ReplicatedCurrentAcceleration.ToOrientationRotator();
+		RuntimeState->LastMovementInputRotation = ReplicatedCurrentAcceleration.ToOrientationRotator();
+
+		if (!bHadMovementInput)
+		{
+			OnMovementInputStarted();
+		}
 	}
 
 	// Set the Aim Yaw rate by comparing the current and previous Aim Yaw value, divided by Delta Seconds.
 	// This represents the speed the camera is rotating left to right.
-	AimYawRate = FMath::Abs((AimingRotation.Yaw - PreviousAimYaw) / DeltaTime);
+	RuntimeState->AimYawRate = FMath::Abs((RuntimeState->AimingRotation.Yaw - RuntimeState->PreviousAimYaw) / DeltaTime);
 }
 
 void AAnonCharacter::UpdateCharacterMovement()
@@ -1072,7 +1332,7 @@ void AAnonCharacter::UpdateCharacterMovement()
 	// Determine the Actual Gait. If it is different from the current Gait, Set the new Gait Event.
 	const EGait ActualGait = GetActualGait(AllowedGait);
 
-	if (ActualGait != Gait)
+	if (ActualGait != RuntimeState->Gait)
 	{
 		SetGait(ActualGait);
 	}
@@ -1083,37 +1343,39 @@ void AAnonCharacter::UpdateCharacterMovement()
 
 void AAnonCharacter::UpdateGroundedRotation(float DeltaTime)
 {
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_UpdateGroundedRotation);
+
 	if (MovementAction == EMovementAction::None)
 	{
-		const bool bCanUpdateMovingRot = ((bIsMoving && bHasMovementInput) || Speed > 150.0f) && !HasAnyRootMotion();
+		const bool bCanUpdateMovingRot = ((RuntimeState->bIsMoving && RuntimeState->bHasMovementInput) || RuntimeState->Speed > 150.0f) && !HasAnyRootMotion();
 		if (bCanUpdateMovingRot)
 		{
 			const float GroundedRotationRate = CalculateGroundedRotationRate();
 			if (RotationMode == ERotationMode::VelocityDirection)
 			{
 				// Velocity Direction Rotation
-				SmoothCharacterRotation({0.0f, LastVelocityRotation.Yaw, 0.0f}, 800.0f, GroundedRotationRate,
+				SmoothCharacterRotation({0.0f, RuntimeState->LastVelocityRotation.Yaw, 0.0f}, 800.0f, GroundedRotationRate,
 				                        DeltaTime);
 			}
 			else if (RotationMode == ERotationMode::LookingDirection)
 			{
 				// Looking Direction Rotation
 				float YawValue;
-				if (Gait == EGait::Sprinting)
+				if (RuntimeState->Gait == EGait::Sprinting)
 				{
-					YawValue = LastVelocityRotation.Yaw;
+					YawValue = RuntimeState->LastVelocityRotation.Yaw;
 				}
 				else
 				{
 					// Walking or Running...
 					const float YawOffsetCurveVal = GetAnimCurveValue(NAME_YawOffset);
-					YawValue = AimingRotation.Yaw + YawOffsetCurveVal;
+					YawValue = RuntimeState->AimingRotation.Yaw + YawOffsetCurveVal;
 				}
 				SmoothCharacterRotation({0.0f, YawValue, 0.0f}, 500.0f, GroundedRotationRate, DeltaTime);
 			}
 			else if (RotationMode == ERotationMode::Aiming)
 			{
-				const float ControlYaw = AimingRotation.Yaw;
+				const float ControlYaw = RuntimeState->AimingRotation.Yaw;
 				SmoothCharacterRotation({0.0f, ControlYaw, 0.0f}, 1000.0f, 20.0f, DeltaTime);
 			}
 		}
@@ -1137,24 +1399,28 @@ void AAnonCharacter::UpdateGroundedRotation(float DeltaTime)
 			{
 				if (GetLocalRole() == ROLE_AutonomousProxy)
 				{
-					TargetRotation.Yaw = UKismetMathLibrary::NormalizeAxis(
-						TargetRotation.Yaw + (RotAmountCurve * (DeltaTime / (1.0f / 30.0f))));
-					SetActorRotation(TargetRotation);
+					RuntimeState->TargetRotation.Yaw = UKismetMathLibrary::NormalizeAxis(
+						RuntimeState->TargetRotation.Yaw + (RotAmountCurve * (DeltaTime / (1.0f / 30.0f))));
+					ApplyActorRotation(RuntimeState->TargetRotation);
 				}
 				else
 				{
-					AddActorWorldRotation({0, RotAmountCurve * (DeltaTime / (1.0f / 30.0f)), 0});
+					// Yaw only, same as adding a world rotation to an upright character
+					FRotator NewRotation = GetActorRotation();
+					NewRotation.Yaw = UKismetMathLibrary::NormalizeAxis(
+						NewRotation.Yaw + RotAmountCurve * (DeltaTime / (1.0f / 30.0f)));
+					ApplyActorRotation(NewRotation);
 				}
-				TargetRotation = GetActorRotation();
+				RuntimeState->TargetRotation = GetActorRotation();
 			}
 		}
 	}
 	else if (MovementAction == EMovementAction::Rolling)
 	{
 		// Rolling Rotation (Not allowed on networked games)
-		if (!bEnableNetworkOptimizations && bHasMovementInput)
+		if (!bEnableNetworkOptimizations && RuntimeState->bHasMovementInput)
 		{
-			SmoothCharacterRotation({0.0f, LastMovementInputRotation.Yaw, 0.0f}, 0.0f, 2.0f, DeltaTime);
+			SmoothCharacterRotation({0.0f, RuntimeState->LastMovementInputRotation.Yaw, 0.0f}, 0.0f, 2.0f, DeltaTime);
 		}
 	}
 
@@ -1171,7 +1437,7 @@ void AAnonCharacter::UpdateInAirRotation(float DeltaTime)
 	else if (RotationMode == ERotationMode::Aiming)
 	{
 		// Aiming Rotation
-		SmoothCharacterRotation({0.0f, AimingRotation.Yaw, 0.0f}, 0.0f, 15.0f, DeltaTime);
+		SmoothCharacterRotation({0.0f, RuntimeState->AimingRotation.Yaw, 0.0f}, 0.0f, 15.0f, DeltaTime);
 		InAirRotation = GetActorRotation();
 	}
 }
@@ -1180,13 +1446,14 @@ void AAnonCharacter::UpdateInAirRotation(float DeltaTime)
 
 void AAnonCharacter::MoveAction(const FInputActionValue& InputValue)
 {
-	if (MovementState != EMovementState::Grounded && MovementState != EMovementState::InAir) return;
+	if (RuntimeState->MovementState != EMovementState::Grounded && RuntimeState->MovementState != EMovementState::InAir) return;
 
 	const FVector2D Value = InputValue.Get<FVector2D>();
+	InputRecorder.Record(ELocomotionInputAction::Move, Value);
 	
 	// Default camera relative movement behavior
-	FRotator AimYawRotation = AimingRotation;
-	AimYawRotation.Pitch = AimingRotation.Roll = 0.f;
+	FRotator AimYawRotation = RuntimeState->AimingRotation;
+	AimYawRotation.Pitch = RuntimeState->AimingRotation.Roll = 0.f;
 
 	const FRotationMatrix AimMatrix = FRotationMatrix(AimYawRotation);
 	const FVector ForwardAim = AimMatrix.GetUnitAxis(EAxis::X);
@@ -1207,6 +1474,7 @@ void AAnonCharacter::LookAction(const FInputActionValue& InputValue)
 void AAnonCharacter::JumpAction(const FInputActionValue& InputValue)
 {
 	const bool bValue = InputValue.Get<bool>();
+	InputRecorder.Record(ELocomotionInputAction::Jump, FVector2D(bValue ? 1.0 : 0.0, 0.0));
 	
 	if (bValue)
 	{
@@ -1218,18 +1486,18 @@ void AAnonCharacter::JumpAction(const FInputActionValue& InputValue)
 
 		if (MovementAction == EMovementAction::None)
 		{
-			if (MovementState == EMovementState::Grounded)
+			if (RuntimeState->MovementState == EMovementState::Grounded)
 			{
-				if (Stance == EStance::Standing)
+				if (RuntimeState->Stance == EStance::Standing)
 				{
 					Traversal->TriggerTraversalAction(true);	
 				}
-				else if (Stance == EStance::Crouching)
+				else if (RuntimeState->Stance == EStance::Crouching)
 				{
 					UnCrouch();
 				}
 			}
-			else if (MovementState == EMovementState::Ragdoll)
+			else if (RuntimeState->MovementState == EMovementState::Ragdoll)
 			{
 				ReplicatedRagdollEnd();
 			}
@@ -1244,6 +1512,7 @@ void AAnonCharacter::JumpAction(const FInputActionValue& InputValue)
 void AAnonCharacter::SprintAction(const FInputActionValue& InputValue)
 {
 	const bool bValue = InputValue.Get<bool>();
+	InputRecorder.Record(ELocomotionInputAction::Sprint, FVector2D(bValue ? 1.0 : 0.0, 0.0));
 	
 	if (bValue)
 	{
@@ -1258,6 +1527,7 @@ void AAnonCharacter::SprintAction(const FInputActionValue& InputValue)
 void AAnonCharacter::AimAction(const FInputActionValue& InputValue)
 {
 	const bool bValue = InputValue.Get<bool>();
+	InputRecorder.Record(ELocomotionInputAction::Aim, FVector2D(bValue ? 1.0 : 0.0, 0.0));
 	
 	if (bValue)
 	{
@@ -1279,6 +1549,8 @@ void AAnonCharacter::AimAction(const FInputActionValue& InputValue)
 
 void AAnonCharacter::CameraTapAction()
 {
+	InputRecorder.Record(ELocomotionInputAction::CameraTap);
+
 	if (ViewMode == EViewMode::FirstPerson)
 	{
 		// Don't swap shoulders on first person mode
@@ -1291,6 +1563,8 @@ void AAnonCharacter::CameraTapAction()
 
 void AAnonCharacter::CameraHeldAction()
 {
+	InputRecorder.Record(ELocomotionInputAction::CameraHeld);
+
 	// Switch camera mode
 	if (ViewMode == EViewMode::FirstPerson)
 	{
@@ -1305,6 +1579,7 @@ void AAnonCharacter::CameraHeldAction()
 void AAnonCharacter::StanceAction()
 {
 	// Stance Action: Press "Stance Action" to toggle Standing / Crouching, double tap to Roll.
+	InputRecorder.Record(ELocomotionInputAction::Stance);
 
 	if (MovementAction != EMovementAction::None)
 	{
@@ -1322,25 +1597,25 @@ void AAnonCharacter::StanceAction()
 		// Roll
 		Replicated_PlayMontage(GetRollAnimation(), 1.15f);
 
-		if (Stance == EStance::Standing)
+		if (RuntimeState->Stance == EStance::Standing)
 		{
 			SetDesiredStance(EStance::Crouching);
 		}
-		else if (Stance == EStance::Crouching)
+		else if (RuntimeState->Stance == EStance::Crouching)
 		{
 			SetDesiredStance(EStance::Standing);
 		}
 		return;
 	}
 
-	if (MovementState == EMovementState::Grounded)
+	if (RuntimeState->MovementState == EMovementState::Grounded)
 	{
-		if (Stance == EStance::Standing)
+		if (RuntimeState->Stance == EStance::Standing)
 		{
 			SetDesiredStance(EStance::Crouching);
 			Crouch();
 		}
-		else if (Stance == EStance::Crouching)
+		else if (RuntimeState->Stance == EStance::Crouching)
 		{
 			SetDesiredStance(EStance::Standing);
 			UnCrouch();
@@ -1352,6 +1627,8 @@ void AAnonCharacter::StanceAction()
 
 void AAnonCharacter::WalkAction()
 {
+	InputRecorder.Record(ELocomotionInputAction::Walk);
+
 	if (DesiredGait == EGait::Walking)
 	{
 		SetDesiredGait(EGait::Running);
@@ -1365,6 +1642,7 @@ void AAnonCharacter::WalkAction()
 void AAnonCharacter::RagdollAction()
 {
 	// Ragdoll Action: Press "Ragdoll Action" to toggle the ragdoll state on or off.
+	InputRecorder.Record(ELocomotionInputAction::Ragdoll);
 
 	if (GetMovementState() == EMovementState::Ragdoll)
 	{
@@ -1380,21 +1658,233 @@ void AAnonCharacter::VelocityDirectionAction()
 {
 	// Select Rotation Mode: Switch the desired (default) rotation mode to Velocity or Looking Direction.
 	// This will be the mode the character reverts back to when un-aiming
+	InputRecorder.Record(ELocomotionInputAction::VelocityDirection);
 	SetDesiredRotationMode(ERotationMode::VelocityDirection);
 	SetRotationMode(ERotationMode::VelocityDirection);
 }
 
 void AAnonCharacter::LookingDirectionAction()
 {
+	InputRecorder.Record(ELocomotionInputAction::LookingDirection);
 	SetDesiredRotationMode(ERotationMode::LookingDirection);
 	SetRotationMode(ERotationMode::LookingDirection);
 }
 
 void AAnonCharacter::ChangeOverlayAction()
 {
+	InputRecorder.Record(ELocomotionInputAction::ChangeOverlay);
 	SetOverlayState(static_cast<EOverlayState>(static_cast<int>(OverlayState) + 1));
 }
 
+//-- Input Replay --//
+
+void AAnonCharacter::StartInputRecording()
+{
+	InputRecorder.Start();
+}
+
+bool AAnonCharacter::StopInputRecording(const FString& Filename)
+{
+	InputRecorder.Stop();
+
+	FLocomotionInputRecording& Recording = InputRecorder.GetRecording();
+	return Recording.Frames.Num() > 0 && Recording.SaveToFile(Filename);
+}
+
+void AAnonCharacter::ReplayInputFrame(const FLocomotionInputFrame& Frame)
+{
+	if (Controller)
+	{
+		Controller->SetControlRotation(Frame.ControlRotation);
+	}
+
+	for (const FLocomotionInputEvent& Event : Frame.Events)
+	{
+		const bool bPressed = Event.Value.X != 0.0;
+		
+		switch (Event.Action)
+		{
+		case ELocomotionInputAction::Move:				MoveAction(FInputActionValue(Event.Value)); break;
+		case ELocomotionInputAction::Jump:				JumpAction(FInputActionValue(bPressed)); break;
+		case ELocomotionInputAction::Sprint:			SprintAction(FInputActionValue(bPressed)); break;
+		case ELocomotionInputAction::Aim:				AimAction(FInputActionValue(bPressed)); break;
+		case ELocomotionInputAction::CameraTap:			CameraTapAction(); break;
+		case ELocomotionInputAction::CameraHeld:		CameraHeldAction(); break;
+		case ELocomotionInputAction::Stance:			StanceAction(); break;
+		case ELocomotionInputAction::Walk:				WalkAction(); break;
+		case ELocomotionInputAction::Ragdoll:			RagdollAction(); break;
+		case ELocomotionInputAction::VelocityDirection:	VelocityDirectionAction(); break;
+		case ELocomotionInputAction::LookingDirection:	LookingDirectionAction(); break;
+		case ELocomotionInputAction::ChangeOverlay:		ChangeOverlayAction(); break;
+		default: break;
+		}
+	}
+}
+
+// ==================== Crowd ==================== //
+
+void AAnonCharacter::ApplyCrowdAgent(const FAnonCrowdAgent& Agent)
+{
+	SetActorLocationAndTargetRotation(Agent.Location, Agent.Rotation);
+	RuntimeState->TargetRotation = Agent.TargetRotation;
+	RuntimeState->AimingRotation = Agent.AimingRotation;
+	RuntimeState->PreviousAimYaw = Agent.AimingRotation.Yaw;
+	if (Controller)
+	{
+		Controller->SetControlRotation(Agent.AimingRotation);
+	}
+
+	// Keep moving at the agent's speed, without an acceleration spike on the first frame
+	GetCharacterMovement()->Velocity = Agent.Velocity;
+	RuntimeState->PreviousVelocity = Agent.Velocity;
+	RuntimeState->Speed = Agent.Speed;
+
+	SetDesiredGait(Agent.DesiredGait);
+	SetDesiredRotationMode(Agent.RotationMode);
+	SetRotationMode(Agent.RotationMode);
+	SetDesiredStance(Agent.Stance);
+	if (Agent.Stance == EStance::Crouching)
+	{
+		Crouch();
+	}
+	else
+	{
+		UnCrouch();
+	}
+	SetGait(Agent.Gait);
+}
+
+void AAnonCharacter::WriteCrowdAgent(FAnonCrowdAgent& Agent) const
+{
+	Agent.Location = GetActorLocation();
+	Agent.Velocity = GetVelocity();
+	Agent.Rotation = GetActorRotation();
+	Agent.TargetRotation = RuntimeState->TargetRotation;
+	Agent.AimingRotation = RuntimeState->AimingRotation;
+	Agent.Speed = RuntimeState->Speed;
+	Agent.DesiredGait = DesiredGait;
+	Agent.Gait = RuntimeState->Gait;
+	Agent.Stance = RuntimeState->Stance;
+	Agent.RotationMode = RotationMode;
+}
+
+// ==================== Pooling ==================== //
+
+void AAnonCharacter::ResetLocomotionState()
+{
+	const AAnonCharacter* Defaults = GetClass()->GetDefaultObject<AAnonCharacter>();
+
+	// Ragdoll, without getting up
+	if (RuntimeState->MovementState == EMovementState::Ragdoll)
+	{
+		if (UKismetSystemLibrary::IsDedicatedServer(GetWorld()))
+		{
+			GetMesh()->VisibilityBasedAnimTickOption = DefVisBasedTickOp;
+		}
+		GetMesh()->bEnableUpdateRateOptimizations = bPreRagdollURO;
+
+		GetMesh()->SetAllBodiesSimulatePhysics(false);
+		GetMesh()->SetCollisionObjectType(ECC_Pawn);
+		GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		SetReplicateMovement(true);
+
+		if (GetMesh()->GetAttachParent() != GetCapsuleComponent())
+		{
+			GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		}
+		GetMesh()->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
+
+		if (RagdollStateChangedDelegate.IsBound())
+		{
+			RagdollStateChangedDelegate.Broadcast(false);
+		}
+	}
+	GetMesh()->bOnlyAllowAutonomousTickPose = false;
+	bRagdollOnGround = false;
+	bRagdollFaceUp = false;
+	LastRagdollVelocity = FVector::ZeroVector;
+	TargetRagdollLocation = FVector::ZeroVector;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, TargetRagdollLocation, this);
+	ServerRagdollPull = 0.0f;
+
+	// Movement
+	GetWorldTimerManager().ClearTimer(OnLandedFrictionResetTimer);
+	OnLandFrictionReset();
+	AnonCharacterMovement->bIgnoreClientMovementErrorChecksAndCorrection = 0;
+	AnonCharacterMovement->StopMovementImmediately();
+	AnonCharacterMovement->SetMovementMode(MOVE_Walking);
+
+	// Runtime state keeps its pool block, only the version keeps counting so readers copy the states again
+	const uint32 StateVersion = RuntimeState->StateVersion;
+	*RuntimeState = FLocomotionRuntimeState();
+	RuntimeState->StateVersion = StateVersion + 1;
+	RuntimeState->MovementState = EMovementState::Grounded;
+
+	MovementAction = EMovementAction::None;
+	GroundedEntryState = EGroundedEntryState::None;
+	OverlayOverrideState = 0;
+	SetDesiredGait(Defaults->DesiredGait);
+	SetDesiredStance(Defaults->DesiredStance);
+	SetDesiredRotationMode(Defaults->DesiredRotationMode);
+	ViewMode = Defaults->ViewMode;
+	OverlayState = Defaults->OverlayState;
+
+	// Same as BeginPlay
+	ForceUpdateCharacterState();
+	if (RuntimeState->Stance == EStance::Standing)
+	{
+		UnCrouch();
+	}
+	else if (RuntimeState->Stance == EStance::Crouching)
+	{
+		Crouch();
+	}
+
+	RuntimeState->TargetRotation = GetActorRotation();
+	RuntimeState->LastVelocityRotation = RuntimeState->TargetRotation;
+	RuntimeState->LastMovementInputRotation = RuntimeState->TargetRotation;
+	RuntimeState->AimingRotation = GetControlRotation();
+	RuntimeState->PreviousAimYaw = RuntimeState->AimingRotation.Yaw;
+	InAirRotation = RuntimeState->TargetRotation;
+	YawOffset = 0.0f;
+
+	AnonCharacterMovement->SetMovementSettings(GetTargetMovementSettings());
+
+	// Input and replication
+	ReplicatedCurrentAcceleration = FVector::ZeroVector;
+	ReplicatedControlRotation = RuntimeState->AimingRotation;
+	ReplicatedLocomotionInput = FReplicatedLocomotionInput();
+	MARK_PROPERTY_DIRTY_FROM_NAME(AAnonCharacter, ReplicatedLocomotionInput, this);
+	LastStanceInputTime = 0.0f;
+	bBreakFall = false;
+	bSprintHeld = false;
+
+	if (bNetIdle)
+	{
+		bNetIdle = false;
+		SetNetUpdateFrequency(DefaultNetUpdateFrequency);
+	}
+	bNetAiming = false;
+	LastReceivedIntent = FLocomotionIntent();
+	LastNetAimTime = 0.0;
+	NetIdleControlRotation = FRotator::ZeroRotator;
+	if (bProxyLOD)
+	{
+		bProxyLOD = false;
+		SetActorTickInterval(FullFidelityTickInterval);
+	}
+	ProxyLODReturnAlpha = 1.0f;
+
+	MontageCurves.Reset();
+	EarlyBlendOuts.Reset();
+	Traversal->ResetTraversal();
+	if (UAnonAnimInstance* AnimInstance = Cast<UAnonAnimInstance>(GetMesh()->GetAnimInstance()))
+	{
+		AnimInstance->ResetAnimationState();
+	}
+}
+
 // ==================== State Changes ==================== //
 
 void AAnonCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
@@ -1417,13 +1907,16 @@ void AAnonCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8
 
 void AAnonCharacter::OnMovementStateChanged(const EMovementState PreviousState)
 {
-	if (MovementState == EMovementState::InAir)
+	MarkStateDirty();
+	UpdateEarlyBlendOuts();
+
+	if (RuntimeState->MovementState == EMovementState::InAir)
 	{
 		if (MovementAction == EMovementAction::None)
 		{
 			// If the character enters the air, set the In Air Rotation and uncrouch if crouched.
 			InAirRotation = GetActorRotation();
-			if (Stance == EStance::Crouching)
+			if (RuntimeState->Stance == EStance::Crouching)
 			{
 				UnCrouch();
 			}
@@ -1434,15 +1927,12 @@ void AAnonCharacter::OnMovementStateChanged(const EMovementState PreviousState)
 			ReplicatedRagdollStart();
 		}
 	}
-
-	if (CameraBehavior)
-	{
-		CameraBehavior->MovementState = MovementState;
-	}
 }
 
 void AAnonCharacter::OnMovementActionChanged(const EMovementAction PreviousAction)
 {
+	MarkStateDirty();
+
 	// Make the character crouch if performing a roll.
 	if (MovementAction == EMovementAction::Rolling)
 	{
@@ -1460,25 +1950,21 @@ void AAnonCharacter::OnMovementActionChanged(const EMovementAction PreviousActio
 			Crouch();
 		}
 	}
-
-	if (CameraBehavior)
-	{
-		CameraBehavior->MovementAction = MovementAction;
-	}
 }
 
 void AAnonCharacter::OnStanceChanged(const EStance PreviousStance)
 {
-	if (CameraBehavior)
-	{
-		CameraBehavior->Stance = Stance;
-	}
+	MarkStateDirty();
+	UpdateEarlyBlendOuts();
 
 	AnonCharacterMovement->SetMovementSettings(GetTargetMovementSettings());
 }
 
 void AAnonCharacter::OnRotationModeChanged(ERotationMode PreviousRotationMode)
 {
+	RuntimeState->RotationMode = RotationMode;
+	MarkStateDirty();
+
 	if (RotationMode == ERotationMode::VelocityDirection && ViewMode == EViewMode::FirstPerson)
 	{
 		// If the new rotation mode is Velocity Direction and the character is in First Person,
@@ -1486,24 +1972,23 @@ void AAnonCharacter::OnRotationModeChanged(ERotationMode PreviousRotationMode)
 		SetViewMode(EViewMode::ThirdPerson);
 	}
 
-	if (CameraBehavior)
-	{
-		CameraBehavior->SetRotationMode(RotationMode);
-	}
-
 	AnonCharacterMovement->SetMovementSettings(GetTargetMovementSettings());
 }
 
 void AAnonCharacter::OnGaitChanged(const EGait PreviousGait)
 {
-	if (CameraBehavior)
-	{
-		CameraBehavior->Gait = Gait;
-	}
+	MarkStateDirty();
+}
+
+void AAnonCharacter::OnMovementInputStarted()
+{
+	UpdateEarlyBlendOuts();
 }
 
 void AAnonCharacter::OnViewModeChanged(const EViewMode PreviousViewMode)
 {
+	MarkStateDirty();
+
 	if (ViewMode == EViewMode::ThirdPerson)
 	{
 		if (RotationMode == ERotationMode::VelocityDirection || RotationMode == ERotationMode::LookingDirection)
@@ -1517,15 +2002,11 @@ void AAnonCharacter::OnViewModeChanged(const EViewMode PreviousViewMode)
 		// If First Person, set the rotation mode to looking direction if currently in the velocity direction mode.
 		SetRotationMode(ERotationMode::LookingDirection);
 	}
-
-	if (CameraBehavior)
-	{
-		CameraBehavior->ViewMode = ViewMode;
-	}
 }
 
 void AAnonCharacter::OnOverlayStateChanged(const EOverlayState PreviousState)
 {
+	MarkStateDirty();
 }
 
 void AAnonCharacter::OnVisibleMeshChanged(const USkeletalMesh* PrevVisibleMesh)
@@ -1567,7 +2048,7 @@ void AAnonCharacter::ForceUpdateCharacterState()
 	SetRotationMode(DesiredRotationMode, true);
 	SetViewMode(ViewMode, true);
 	SetOverlayState(OverlayState, true);
-	SetMovementState(MovementState, true);
+	SetMovementState(RuntimeState->MovementState, true);
 	SetMovementAction(MovementAction, true);
 }
 
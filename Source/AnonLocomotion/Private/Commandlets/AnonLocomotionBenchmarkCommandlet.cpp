@@ -0,0 +1,385 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Commandlets/AnonLocomotionBenchmarkCommandlet.h"
+
+UAnonLocomotionBenchmarkCommandlet::UAnonLocomotionBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Replays a locomotion input recording on N characters and writes per stage timings as JSON");
+	HelpUsage = TEXT("-run=AnonLocomotionBenchmark -nullrhi -Map=<map> -Recording=<file> [-Character=<class>] "
+		"[-Copies=16] [-Spacing=300] [-PlayerController=<class>] [-CrowdAgents=0] [-CrowdSpacing=200] "
+		"[-SpawnCycles=0] [-Output=<file.json>]");
+}
+
+#if WITH_EDITOR
+
+#include "EngineUtils.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Characters/AnonCharacter.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/WorldSettings.h"
+#include "Library/LocomotionProfiling.h"
+#include "Library/LocomotionReplay.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Subsystems/AnonCharacterPoolSubsystem.h"
+#include "Subsystems/AnonCrowdSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogAnonLocomotionBenchmark, Log, All);
+
+int32 UAnonLocomotionBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	FString RecordingName;
+	FString CharacterClassName;
+	FString PlayerControllerClassName;
+	FString OutputName = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("AnonLocomotion.json");
+	int32 NumCopies = 16;
+	float Spacing = 300.0f;
+	int32 NumCrowdAgents = 0;
+	float CrowdSpacing = 200.0f;
+	int32 NumSpawnCycles = 0;
+
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Recording="), RecordingName);
+	FParse::Value(*Params, TEXT("Character="), CharacterClassName);
+	FParse::Value(*Params, TEXT("PlayerController="), PlayerControllerClassName);
+	FParse::Value(*Params, TEXT("Output="), OutputName);
+	FParse::Value(*Params, TEXT("Copies="), NumCopies);
+	FParse::Value(*Params, TEXT("Spacing="), Spacing);
+	FParse::Value(*Params, TEXT("CrowdAgents="), NumCrowdAgents);
+	FParse::Value(*Params, TEXT("CrowdSpacing="), CrowdSpacing);
+	FParse::Value(*Params, TEXT("SpawnCycles="), NumSpawnCycles);
+	NumCopies = FMath::Max(NumCopies, 1);
+	NumCrowdAgents = FMath::Max(NumCrowdAgents, 0);
+
+	if (MapName.IsEmpty() || RecordingName.IsEmpty())
+	{
+		UE_LOG(LogAnonLocomotionBenchmark, Error, TEXT("Usage: %s"), *HelpUsage);
+		return 1;
+	}
+
+	FLocomotionInputRecording Recording;
+	if (!Recording.LoadFromFile(RecordingName) || Recording.Frames.Num() == 0)
+	{
+		UE_LOG(LogAnonLocomotionBenchmark, Error, TEXT("Failed to load recording %s"), *RecordingName);
+		return 1;
+	}
+
+	UClass* CharacterClass = CharacterClassName.IsEmpty()
+		                         ? AAnonCharacter::StaticClass()
+		                         : LoadClass<AAnonCharacter>(nullptr, *CharacterClassName);
+	UClass* PlayerControllerClass = PlayerControllerClassName.IsEmpty()
+		                                ? nullptr
+		                                : LoadClass<APlayerController>(nullptr, *PlayerControllerClassName);
+	if (!CharacterClass || (!PlayerControllerClassName.IsEmpty() && !PlayerControllerClass))
+	{
+		UE_LOG(LogAnonLocomotionBenchmark, Error, TEXT("Failed to load character or player controller class"));
+		return 1;
+	}
+
+	UWorld* World = LoadBenchmarkWorld(MapName);
+	if (!World)
+	{
+		UE_LOG(LogAnonLocomotionBenchmark, Error, TEXT("Failed to load map %s"), *MapName);
+		return 1;
+	}
+
+	TArray<AAnonCharacter*> Characters;
+	APlayerController* PlayerController = nullptr;
+	SpawnCopies(*World, CharacterClass, NumCopies, Spacing, PlayerControllerClass, Characters, PlayerController);
+
+	TArray<FAnonCrowdAgentHandle> CrowdAgents;
+	AddCrowdAgents(*World, CharacterClass, NumCrowdAgents, CrowdSpacing, CrowdAgents);
+
+	FLocomotionBenchmarkTimers::Reset();
+	FLocomotionBenchmarkTimers::SetEnabled(true);
+
+	// Fixed, recorded delta times so every run simulates exactly the same frames
+	const double StartSeconds = FPlatformTime::Seconds();
+	for (int32 FrameIndex = 0; FrameIndex < Recording.Frames.Num(); ++FrameIndex)
+	{
+		const FLocomotionInputFrame& Frame = Recording.Frames[FrameIndex];
+		FApp::SetDeltaTime(Frame.DeltaTime);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + Frame.DeltaTime);
+
+		for (AAnonCharacter* Character : Characters)
+		{
+			if (IsValid(Character))
+			{
+				Character->ReplayInputFrame(Frame);
+			}
+		}
+		SteerCrowdAgents(*World, CrowdAgents, FrameIndex);
+
+		World->Tick(LEVELTICK_All, Frame.DeltaTime);
+
+		if (PlayerController && PlayerController->PlayerCameraManager)
+		{
+			PlayerController->PlayerCameraManager->UpdateCamera(Frame.DeltaTime);
+		}
+	}
+	const double WallSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	FLocomotionBenchmarkTimers::SetEnabled(false);
+
+	const FSpawnCost SpawnCost = MeasureSpawnCost(*World, CharacterClass, NumSpawnCycles);
+
+	const bool bWritten = WriteReport(OutputName, MapName, RecordingName, CharacterClass, NumCopies,
+	                                  CrowdAgents.Num(), Recording.Frames.Num(), WallSeconds, SpawnCost);
+
+	DestroyBenchmarkWorld(World);
+
+	return bWritten ? 0 : 1;
+}
+
+UWorld* UAnonLocomotionBenchmarkCommandlet::LoadBenchmarkWorld(const FString& MapName)
+{
+	UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!World) return nullptr;
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true));
+	}
+
+	World->UpdateWorldComponents(true, true);
+	World->InitializeActorsForPlay(FURL());
+
+	// No game instance, hence no game mode to start play: dispatch BeginPlay through the world settings instead
+	World->BeginPlay();
+	if (!World->HasBegunPlay())
+	{
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	return World;
+}
+
+void UAnonLocomotionBenchmarkCommandlet::DestroyBenchmarkWorld(UWorld* World)
+{
+	World->DestroyWorld(false);
+	GEngine->DestroyWorldContext(World);
+	World->RemoveFromRoot();
+
+	CollectGarbage(RF_NoFlags);
+}
+
+void UAnonLocomotionBenchmarkCommandlet::SpawnCopies(UWorld& World, UClass* CharacterClass, int32 NumCopies,
+                                                     float Spacing, UClass* PlayerControllerClass,
+                                                     TArray<AAnonCharacter*>& OutCharacters,
+                                                     APlayerController*& OutPlayerController)
+{
+	FTransform Origin = FTransform::Identity;
+	for (TActorIterator<APlayerStart> It(&World); It; ++It)
+	{
+		Origin = It->GetActorTransform();
+		break;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// Square grid so the copies don't collide with each other
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCopies)));
+	OutCharacters.Reserve(NumCopies);
+	for (int32 i = 0; i < NumCopies; ++i)
+	{
+		const FVector Offset((i / GridSize) * Spacing, (i % GridSize) * Spacing, 0.0f);
+		const FTransform SpawnTransform(Origin.GetRotation(), Origin.TransformPosition(Offset));
+
+		AAnonCharacter* Character = World.SpawnActor<AAnonCharacter>(CharacterClass, SpawnTransform, SpawnParams);
+		if (!Character) continue;
+
+		if (i == 0 && PlayerControllerClass)
+		{
+			OutPlayerController = World.SpawnActor<APlayerController>(PlayerControllerClass, SpawnTransform, SpawnParams);
+			if (OutPlayerController)
+			{
+				OutPlayerController->Possess(Character);
+			}
+		}
+
+		if (!Character->GetController())
+		{
+			Character->SpawnDefaultController();
+		}
+		OutCharacters.Add(Character);
+	}
+}
+
+void UAnonLocomotionBenchmarkCommandlet::AddCrowdAgents(UWorld& World, UClass* CharacterClass, int32 NumAgents,
+                                                        float Spacing, TArray<FAnonCrowdAgentHandle>& OutAgents)
+{
+	UAnonCrowdSubsystem* Crowd = World.GetSubsystem<UAnonCrowdSubsystem>();
+	if (!Crowd || NumAgents == 0) return;
+
+	FTransform Origin = FTransform::Identity;
+	for (TActorIterator<APlayerStart> It(&World); It; ++It)
+	{
+		Origin = It->GetActorTransform();
+		break;
+	}
+
+	// Grid behind the copies, along -X
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumAgents)));
+	OutAgents.Reserve(NumAgents);
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		const FVector Offset(-(1 + i / GridSize) * Spacing, (i % GridSize) * Spacing, 0.0f);
+		const FTransform Transform(Origin.GetRotation(), Origin.TransformPosition(Offset));
+
+		const FAnonCrowdAgentHandle Handle = Crowd->AddAgent(CharacterClass, Transform);
+		if (Handle.IsValid())
+		{
+			OutAgents.Add(Handle);
+		}
+	}
+}
+
+void UAnonLocomotionBenchmarkCommandlet::SteerCrowdAgents(UWorld& World, const TArray<FAnonCrowdAgentHandle>& Agents,
+                                                          int32 FrameIndex)
+{
+	UAnonCrowdSubsystem* Crowd = World.GetSubsystem<UAnonCrowdSubsystem>();
+	if (!Crowd) return;
+
+	static const EGait Gaits[] = {EGait::Walking, EGait::Running, EGait::Sprinting};
+
+	for (int32 i = 0; i < Agents.Num(); ++i)
+	{
+		// Deterministic per agent heading, slowly turning
+		const float Yaw = i * 137.5f + FrameIndex * 0.5f;
+		Crowd->SetAgentMovementInput(Agents[i], FRotator(0.0f, Yaw, 0.0f).Vector());
+
+		// Gait change every 2 seconds at 60 fps, staggered between agents
+		if ((FrameIndex + i) % 120 == 0)
+		{
+			Crowd->SetAgentDesiredGait(Agents[i], Gaits[((FrameIndex + i) / 120) % UE_ARRAY_COUNT(Gaits)]);
+		}
+	}
+}
+
+UAnonLocomotionBenchmarkCommandlet::FSpawnCost UAnonLocomotionBenchmarkCommandlet::MeasureSpawnCost(
+	UWorld& World, UClass* CharacterClass, int32 NumCycles)
+{
+	FSpawnCost Cost;
+
+	UAnonCharacterPoolSubsystem* Pool = World.GetSubsystem<UAnonCharacterPoolSubsystem>();
+	if (!Pool || NumCycles <= 0) return Cost;
+
+	FTransform Origin = FTransform::Identity;
+	for (TActorIterator<APlayerStart> It(&World); It; ++It)
+	{
+		Origin = It->GetActorTransform();
+		break;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// Each cycle ticks the world once, like a respawn on a later frame would
+	const float DeltaTime = 1.0f / 60.0f;
+	double SpawnSeconds = 0.0;
+	for (int32 i = 0; i < NumCycles; ++i)
+	{
+		const double Start = FPlatformTime::Seconds();
+		if (AAnonCharacter* Character = World.SpawnActor<AAnonCharacter>(CharacterClass, Origin, SpawnParams))
+		{
+			Character->Destroy();
+		}
+		SpawnSeconds += FPlatformTime::Seconds() - Start;
+		World.Tick(LEVELTICK_All, DeltaTime);
+	}
+
+	Pool->Prewarm(CharacterClass, 1, Origin);
+	double PooledSeconds = 0.0;
+	for (int32 i = 0; i < NumCycles; ++i)
+	{
+		const double Start = FPlatformTime::Seconds();
+		Pool->ReleaseCharacter(Pool->AcquireCharacter(CharacterClass, Origin));
+		PooledSeconds += FPlatformTime::Seconds() - Start;
+		World.Tick(LEVELTICK_All, DeltaTime);
+	}
+
+	Cost.Cycles = NumCycles;
+	Cost.SpawnMs = SpawnSeconds * 1000.0;
+	Cost.PooledMs = PooledSeconds * 1000.0;
+	return Cost;
+}
+
+bool UAnonLocomotionBenchmarkCommandlet::WriteReport(const FString& Filename, const FString& MapName,
+                                                     const FString& RecordingName, const UClass* CharacterClass,
+                                                     int32 NumCopies, int32 NumCrowdAgents, int32 NumFrames,
+                                                     double WallSeconds, const FSpawnCost& SpawnCost)
+{
+	// Keys and layout are consumed by CI, bump OutputFormatVersion on any change
+	const TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("format"), OutputFormatVersion);
+	Root->SetStringField(TEXT("map"), MapName);
+	Root->SetStringField(TEXT("recording"), FPaths::GetCleanFilename(RecordingName));
+	Root->SetStringField(TEXT("character"), CharacterClass->GetPathName());
+	Root->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+	Root->SetNumberField(TEXT("copies"), NumCopies);
+	Root->SetNumberField(TEXT("crowd_agents"), NumCrowdAgents);
+	Root->SetNumberField(TEXT("frames"), NumFrames);
+	Root->SetNumberField(TEXT("wall_ms"), WallSeconds * 1000.0);
+
+	const TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < static_cast<int32>(ELocomotionProfileStage::Num); ++i)
+	{
+		const ELocomotionProfileStage Stage = static_cast<ELocomotionProfileStage>(i);
+		const uint64 Calls = FLocomotionBenchmarkTimers::GetCalls(Stage);
+		const double TotalMs = FPlatformTime::ToMilliseconds64(FLocomotionBenchmarkTimers::GetCycles(Stage));
+
+		const TSharedRef<FJsonObject> StageObject = MakeShared<FJsonObject>();
+		StageObject->SetNumberField(TEXT("calls"), static_cast<double>(Calls));
+		StageObject->SetNumberField(TEXT("total_ms"), TotalMs);
+		StageObject->SetNumberField(TEXT("avg_us"), Calls > 0 ? TotalMs * 1000.0 / Calls : 0.0);
+		StageObject->SetNumberField(TEXT("per_frame_ms"), NumFrames > 0 ? TotalMs / NumFrames : 0.0);
+		Stages->SetObjectField(FLocomotionBenchmarkTimers::GetStageName(Stage), StageObject);
+	}
+	Root->SetObjectField(TEXT("stages"), Stages);
+
+	if (SpawnCost.Cycles > 0)
+	{
+		const TSharedRef<FJsonObject> Spawn = MakeShared<FJsonObject>();
+		Spawn->SetNumberField(TEXT("cycles"), SpawnCost.Cycles);
+		Spawn->SetNumberField(TEXT("spawn_destroy_avg_us"), SpawnCost.SpawnMs * 1000.0 / SpawnCost.Cycles);
+		Spawn->SetNumberField(TEXT("acquire_release_avg_us"), SpawnCost.PooledMs * 1000.0 / SpawnCost.Cycles);
+		Root->SetObjectField(TEXT("spawn"), Spawn);
+	}
+
+	FString Output;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	if (!FJsonSerializer::Serialize(Root, Writer))
+	{
+		return false;
+	}
+
+	UE_LOG(LogAnonLocomotionBenchmark, Display, TEXT("%s"), *Output);
+
+	if (!FFileHelper::SaveStringToFile(Output, *Filename))
+	{
+		UE_LOG(LogAnonLocomotionBenchmark, Error, TEXT("Failed to write %s"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+#endif
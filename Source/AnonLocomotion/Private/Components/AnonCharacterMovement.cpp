@@ -2,38 +2,44 @@
 
 #include "Components/AnonCharacterMovement.h"
 
+#include "Characters/AnonCharacter.h"
 #include "Curves/CurveVector.h"
 #include "GameFramework/Character.h"
+#include "Library/LocomotionProfiling.h"
+#include "Library/LocomotionRules.h"
+#include "Misc/Crc.h"
 
-
-void UAnonCharacterMovement::OnMovementUpdated(float DeltaTime, const FVector& OldLocation,
-                                               const FVector& OldVelocity)
+/** Depends only on the settings content, unlike a change counter it can't drift when one side sets them more often */
+static uint32 HashMovementSettings(const FMovementSettings& Settings)
 {
-	Super::OnMovementUpdated(DeltaTime, OldLocation, OldVelocity);
+	uint32 Crc = FCrc::MemCrc32(&Settings.WalkSpeed, sizeof(Settings.WalkSpeed));
+	Crc = FCrc::MemCrc32(&Settings.RunSpeed, sizeof(Settings.RunSpeed), Crc);
+	Crc = FCrc::MemCrc32(&Settings.SprintSpeed, sizeof(Settings.SprintSpeed), Crc);
+	Crc = FCrc::StrCrc32(*GetPathNameSafe(Settings.MovementCurve.Get()), Crc);
+	return FCrc::StrCrc32(*GetPathNameSafe(Settings.RotationRateCurve.Get()), Crc);
+}
 
-	if (!CharacterOwner)
-	{
-		return;
-	}
+UAnonCharacterMovement::UAnonCharacterMovement(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SetNetworkMoveDataContainer(AnonMoveDataContainer);
+}
 
-	// Set Movement Settings
-	if (bRequestMovementSettingsChange)
-	{
-		const float UpdateMaxWalkSpeed = CurrentMovementSettings.GetSpeedForGait(AllowedGait);
-		MaxWalkSpeed = UpdateMaxWalkSpeed;
-		MaxWalkSpeedCrouched = UpdateMaxWalkSpeed;
+void UAnonCharacterMovement::TickComponent(float DeltaTime, ELevelTick TickType,
+                                           FActorComponentTickFunction* ThisTickFunction)
+{
+	LOCOMOTION_BENCHMARK_SCOPE(CharacterMovement);
 
-		bRequestMovementSettingsChange = false;
-	}
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 }
 
 void UAnonCharacterMovement::PhysWalking(float deltaTime, int32 Iterations)
 {
-	if (CurrentMovementSettings.MovementCurve)
+	if (BakedMovementCurve.IsValid())
 	{
 		// Update the Ground Friction using the Movement Curve.
 		// This allows for fine control over movement behavior at each speed.
-		GroundFriction = CurrentMovementSettings.MovementCurve->GetVectorValue(GetMappedSpeed()).Z;
+		GroundFriction = GetMovementCurveValue().Z;
 	}
 	Super::PhysWalking(deltaTime, Iterations);
 }
@@ -42,30 +48,67 @@ float UAnonCharacterMovement::GetMaxAcceleration() const
 {
 	// Update the Acceleration using the Movement Curve.
 	// This allows for fine control over movement behavior at each speed.
-	if (!IsMovingOnGround() || !CurrentMovementSettings.MovementCurve)
+	if (!IsMovingOnGround() || !BakedMovementCurve.IsValid())
 	{
 		return Super::GetMaxAcceleration();
 	}
 	
-	return CurrentMovementSettings.MovementCurve->GetVectorValue(GetMappedSpeed()).X;
+	return GetMovementCurveValue().X;
 }
 
 float UAnonCharacterMovement::GetMaxBrakingDeceleration() const
 {
 	// Update the Deceleration using the Movement Curve.
 	// This allows for fine control over movement behavior at each speed.
-	if (!IsMovingOnGround() || !CurrentMovementSettings.MovementCurve)
+	if (!IsMovingOnGround() || !BakedMovementCurve.IsValid())
 	{
 		return Super::GetMaxBrakingDeceleration();
 	}
-	return CurrentMovementSettings.MovementCurve->GetVectorValue(GetMappedSpeed()).Y;
+	return GetMovementCurveValue().Y;
 }
 
-void UAnonCharacterMovement::UpdateFromCompressedFlags(uint8 Flags) // Client only
+const FVector& UAnonCharacterMovement::GetMovementCurveValue() const
 {
-	Super::UpdateFromCompressedFlags(Flags);
+	// Baked samples instead of evaluating the curve, client and server land on the same sample for nearly equal speeds
+	return BakedMovementCurve->Sample(GetMappedSpeed());
+}
 
-	bRequestMovementSettingsChange = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+void UAnonCharacterMovement::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags,
+                                            const FVector& NewAccel) // Server only
+{
+	// Apply the client's intents and gait first, so the move is simulated with the same movement settings the client used
+	const FAnonNetworkMoveData* MoveData = static_cast<const FAnonNetworkMoveData*>(GetCurrentNetworkMoveData());
+	if (MoveData)
+	{
+		EGait MoveGait = MoveData->AllowedGait;
+		if (AAnonCharacter* AnonCharacter = Cast<AAnonCharacter>(CharacterOwner))
+		{
+			AnonCharacter->ApplyLocomotionIntent(MoveData->Intent);
+
+			// The client may be slower than its states allow (e.g. sprint released early), never faster
+			const EGait MaxGait = AnonCharacter->GetMaxAllowedGaitForMove();
+			if (MoveGait > MaxGait)
+			{
+				MoveGait = MaxGait;
+				LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_RejectedClientGait, 1);
+			}
+		}
+
+		if (AllowedGait != MoveGait)
+		{
+			AllowedGait = MoveGait;
+			UpdateMaxWalkSpeed();
+		}
+
+		// Both sides derive the settings from the intents applied above, a mismatch means the data itself differs or the
+		// server missed a settings change
+		if (MovementSettingsHash != MoveData->MovementSettingsHash)
+		{
+			LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_MovementSettingsMismatch, 1);
+		}
+	}
+
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
 }
 
 class FNetworkPredictionData_Client* UAnonCharacterMovement::GetPredictionData_Client() const
@@ -88,20 +131,39 @@ void UAnonCharacterMovement::FSavedMove_Anon::Clear()
 {
 	Super::Clear();
 
-	bSavedRequestMovementSettingsChange = false;
 	SavedAllowedGait = EGait::Walking;
+	SavedMovementSettings = FMovementSettings();
+	SavedMovementSettingsHash = 0;
+	SavedIntent = FLocomotionIntent();
 }
 
-uint8 UAnonCharacterMovement::FSavedMove_Anon::GetCompressedFlags() const
+bool UAnonCharacterMovement::FSavedMove_Anon::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
 {
-	uint8 Result = Super::GetCompressedFlags();
+	// Don't let an intent or gait change wait behind move combining / net update throttling
+	if (LastAckedMove.IsValid())
+	{
+		const FSavedMove_Anon* LastAckedAnonMove = static_cast<const FSavedMove_Anon*>(LastAckedMove.Get());
+		if (LastAckedAnonMove->SavedIntent != SavedIntent || LastAckedAnonMove->SavedAllowedGait != SavedAllowedGait)
+		{
+			return true;
+		}
+	}
+
+	return Super::IsImportantMove(LastAckedMove);
+}
 
-	if (bSavedRequestMovementSettingsChange)
+bool UAnonCharacterMovement::FSavedMove_Anon::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter,
+                                                             float MaxDelta) const
+{
+	// A combined move is replayed with one gait and one set of intents, only merge moves that agree on them
+	const FSavedMove_Anon* NewAnonMove = static_cast<const FSavedMove_Anon*>(NewMove.Get());
+	if (SavedAllowedGait != NewAnonMove->SavedAllowedGait || SavedIntent != NewAnonMove->SavedIntent
+		|| SavedMovementSettingsHash != NewAnonMove->SavedMovementSettingsHash)
 	{
-		Result |= FLAG_Custom_0;
+		return false;
 	}
 
-	return Result;
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
 }
 
 void UAnonCharacterMovement::FSavedMove_Anon::SetMoveFor(ACharacter* Character, float InDeltaTime,
@@ -114,8 +176,14 @@ void UAnonCharacterMovement::FSavedMove_Anon::SetMoveFor(ACharacter* Character,
 	UAnonCharacterMovement* CharacterMovement = Cast<UAnonCharacterMovement>(Character->GetCharacterMovement());
 	if (CharacterMovement)
 	{
-		bSavedRequestMovementSettingsChange = CharacterMovement->bRequestMovementSettingsChange;
 		SavedAllowedGait = CharacterMovement->AllowedGait;
+		SavedMovementSettings = CharacterMovement->CurrentMovementSettings;
+		SavedMovementSettingsHash = CharacterMovement->MovementSettingsHash;
+	}
+
+	if (const AAnonCharacter* AnonCharacter = Cast<AAnonCharacter>(Character))
+	{
+		SavedIntent = AnonCharacter->GetLocomotionIntent();
 	}
 }
 
@@ -124,9 +192,18 @@ void UAnonCharacterMovement::FSavedMove_Anon::PrepMoveFor(ACharacter* Character)
 	Super::PrepMoveFor(Character);
 
 	UAnonCharacterMovement* CharacterMovement = Cast<UAnonCharacterMovement>(Character->GetCharacterMovement());
-	if (CharacterMovement)
+	if (!CharacterMovement) return;
+
+	// Replayed after a correction, with the settings and speed the move originally had
+	if (CharacterMovement->MovementSettingsHash != SavedMovementSettingsHash)
 	{
 		CharacterMovement->AllowedGait = SavedAllowedGait;
+		CharacterMovement->SetMovementSettings(SavedMovementSettings);
+	}
+	else if (CharacterMovement->AllowedGait != SavedAllowedGait)
+	{
+		CharacterMovement->AllowedGait = SavedAllowedGait;
+		CharacterMovement->UpdateMaxWalkSpeed();
 	}
 }
 
@@ -141,61 +218,72 @@ FSavedMovePtr UAnonCharacterMovement::FNetworkPredictionData_Client_Anon::Alloca
 	return MakeShared<FSavedMove_Anon>();
 }
 
-void UAnonCharacterMovement::Server_SetAllowedGait_Implementation(const EGait NewAllowedGait)
+void UAnonCharacterMovement::FAnonNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove,
+                                                                             ENetworkMoveType MoveType)
 {
-	AllowedGait = NewAllowedGait;
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	const FSavedMove_Anon& AnonMove = static_cast<const FSavedMove_Anon&>(ClientMove);
+	AllowedGait = AnonMove.SavedAllowedGait;
+	MovementSettingsHash = AnonMove.SavedMovementSettingsHash;
+	Intent = AnonMove.SavedIntent;
 }
 
-float UAnonCharacterMovement::GetMappedSpeed() const
+bool UAnonCharacterMovement::FAnonNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement,
+                                                             FArchive& Ar, UPackageMap* PackageMap,
+                                                             ENetworkMoveType MoveType)
 {
-	// Map the character's current speed to the configured movement speeds with a range of 0-3,
-	// with 0 = stopped, 1 = the Walk Speed, 2 = the Run Speed, and 3 = the Sprint Speed.
-	// This allows us to vary the movement speeds but still use the mapped range in calculations for consistent results
+	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
 
-	const float Speed = Velocity.Size2D();
-	const float LocWalkSpeed = CurrentMovementSettings.WalkSpeed;
-	const float LocRunSpeed = CurrentMovementSettings.RunSpeed;
-	const float LocSprintSpeed = CurrentMovementSettings.SprintSpeed;
+	uint8 Gait = static_cast<uint8>(AllowedGait);
+	Ar.SerializeBits(&Gait, 2);
+	AllowedGait = static_cast<EGait>(Gait);
 
-	if (Speed > LocRunSpeed)
-	{
-		return FMath::GetMappedRangeValueClamped<float, float>({LocRunSpeed, LocSprintSpeed}, {2.0f, 3.0f}, Speed);
-	}
+	Ar << MovementSettingsHash;
 
-	if (Speed > LocWalkSpeed)
-	{
-		return FMath::GetMappedRangeValueClamped<float, float>({LocWalkSpeed, LocRunSpeed}, {1.0f, 2.0f}, Speed);
-	}
+	Intent.Serialize(Ar);
+
+	return !Ar.IsError();
+}
 
-	return FMath::GetMappedRangeValueClamped<float, float>({0.0f, LocWalkSpeed}, {0.0f, 1.0f}, Speed);
+UAnonCharacterMovement::FAnonNetworkMoveDataContainer::FAnonNetworkMoveDataContainer()
+{
+	NewMoveData = &MoveData[0];
+	PendingMoveData = &MoveData[1];
+	OldMoveData = &MoveData[2];
+}
+
+float UAnonCharacterMovement::GetMappedSpeed() const
+{
+	// Map the character's current speed to the configured movement speeds with a range of 0-3,
+	// with 0 = stopped, 1 = the Walk Speed, 2 = the Run Speed, and 3 = the Sprint Speed.
+	return FLocomotionRules::GetMappedSpeed(Velocity.Size2D(), CurrentMovementSettings);
 }
 
 void UAnonCharacterMovement::SetMovementSettings(const FMovementSettings& NewMovementSettings)
 {
 	// Set the current movement settings from the owner
 	CurrentMovementSettings = NewMovementSettings;
-	bRequestMovementSettingsChange = true;
+	MovementSettingsHash = HashMovementSettings(NewMovementSettings);
+	BakedMovementCurve = FMovementCurveCache::Find(NewMovementSettings.MovementCurve);
+
+	UpdateMaxWalkSpeed();
 }
 
 void UAnonCharacterMovement::SetAllowedGait(const EGait NewAllowedGait)
 {
-	if (AllowedGait != NewAllowedGait)
-	{
-		if (PawnOwner->IsLocallyControlled())
-		{
-			AllowedGait = NewAllowedGait;
-			if (GetCharacterOwner()->GetLocalRole() == ROLE_AutonomousProxy)
-			{
-				Server_SetAllowedGait(NewAllowedGait);
-			}
-			bRequestMovementSettingsChange = true;
-			return;
-		}
-		if (!PawnOwner->HasAuthority())
-		{
-			const float UpdateMaxWalkSpeed = CurrentMovementSettings.GetSpeedForGait(AllowedGait);
-			MaxWalkSpeed = UpdateMaxWalkSpeed;
-			MaxWalkSpeedCrouched = UpdateMaxWalkSpeed;
-		}
-	}
+	if (AllowedGait == NewAllowedGait) return;
+
+	// A remote client's gait arrives with its moves, in order with the movement it belongs to (see MoveAutonomous)
+	if (PawnOwner->HasAuthority() && !PawnOwner->IsLocallyControlled()) return;
+
+	AllowedGait = NewAllowedGait;
+	UpdateMaxWalkSpeed();
+}
+
+void UAnonCharacterMovement::UpdateMaxWalkSpeed()
+{
+	const float NewMaxWalkSpeed = CurrentMovementSettings.GetSpeedForGait(AllowedGait);
+	MaxWalkSpeed = NewMaxWalkSpeed;
+	MaxWalkSpeedCrouched = NewMaxWalkSpeed;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "MotionWarpingComponent.h"
 #include "Characters/AnonAnimInstance.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Library/LocomotionProfiling.h"
 
 UTraversalComponent::UTraversalComponent()
 {
@@ -121,6 +122,7 @@ FHitResult UTraversalComponent::DetectWall() const
 		const FVector Start = EntryStart + Character->GetActorUpVector() * /* Gap */ 20.f * I;
 		const FVector End = Start + Character->GetActorForwardVector() * FrontDetectLength;
 		
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 		UKismetSystemLibrary::SphereTraceSingle(Character.Get(), Start, End, 8.f,TraceTypeQuery1,
 			false, TArray<AActor*>(), EDrawDebugTrace::ForOneFrame, WallResult, true
 		);
@@ -142,6 +144,7 @@ void UTraversalComponent::GatherScanVertically(TArray<FHitResult>& LineHitTraces
 
 		FHitResult LineResult;
 			
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 		UKismetSystemLibrary::LineTraceSingle(Character.Get(), TraceStart, TraceEnd, TraceTypeQuery1,
 			false, TArray<AActor*>(), EDrawDebugTrace::None, LineResult, true
 		);
@@ -201,6 +204,7 @@ void UTraversalComponent::GatherWallTop(FHitResult& LastTopHit)
 		const FVector StartTrace = PivotPoint + FVector(0.f, 0.f, 25.f);
 		const FVector EndTrace = PivotPoint  - FVector(0.f, 0.f, 25.f); 
 		
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 		UKismetSystemLibrary::SphereTraceSingle(Character.Get(), StartTrace, EndTrace, 2.5f, TraceTypeQuery1,
 			false, TArray<AActor*>(), EDrawDebugTrace::None, TopResult, true
 		);
@@ -232,6 +236,7 @@ void UTraversalComponent::GetVaultLanding(const FVector& WallForward, const FVec
 		const FVector VaultStart = WallDepthResult.ImpactPoint + WallForward * 70.f;
 		const FVector VaultEnd = VaultStart - WallUp * 200.f;
 		
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 		UKismetSystemLibrary::SphereTraceSingle(Character.Get(), VaultStart, VaultEnd, 10.f, TraceTypeQuery1,
 			false, TArray<AActor*>(), EDrawDebugTrace::None, WallVaultResult, true
 		);
@@ -245,6 +250,7 @@ void UTraversalComponent::GetWallDepth(const FVector& WallForward, const FHitRes
 	const FVector StartTrace = LastTopHit.ImpactPoint + WallForward * 50.f; 
 	const FVector EndTrace = LastTopHit.ImpactPoint;
 	
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
 	UKismetSystemLibrary::SphereTraceSingle(Character.Get(), StartTrace, EndTrace, 10.f, TraceTypeQuery1,
 	                                        false, TArray<AActor*>(), EDrawDebugTrace::None, WallDepthResult, true
 	);
@@ -252,6 +258,8 @@ void UTraversalComponent::GetWallDepth(const FVector& WallForward, const FHitRes
 
 void UTraversalComponent::WallScan(const FVector& BaseLocation, const FRotator& BaseRotation)
 {
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_WallScan);
+
 	TArray<FHitResult> WallHitTraces;
 	TArray<FHitResult> LineHitTraces;
 
@@ -366,8 +374,21 @@ void UTraversalComponent::ResetResult()
 	WallHeight = WallDepth = VaultHeight = 0.f;
 }
 
+void UTraversalComponent::ResetTraversal()
+{
+	ResetResult();
+	WallRotation = FRotator::ZeroRotator;
+	TraversalAction = ETraversalAction::NoAction;
+
+	SetTraversalState(ETraversalState::FreeRoam);
+	SetTraversalDirection(ETraversalDirection::Forward);
+	SetClimbStyle(EClimbStyle::BracedClimb);
+}
+
 void UTraversalComponent::TriggerTraversalAction(const bool bJumpAction)
 {
+	LOCOMOTION_BENCHMARK_SCOPE(Traversal);
+
 	if (TraversalAction != ETraversalAction::NoAction) return;
 
 	const FHitResult WallResult = DetectWall();
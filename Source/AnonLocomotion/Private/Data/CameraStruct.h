@@ -0,0 +1,158 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocomotionEnum.h"
+#include "CameraStruct.generated.h"
+
+/** Every value the camera behavior used to read as an anim curve (PivotLagSpeed_X, CameraOffset_Y, ...) */
+USTRUCT(BlueprintType)
+struct FCameraBehaviorParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera")
+	FVector PivotLagSpeed = FVector(15.0f);
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera")
+	FVector PivotOffset = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera")
+	FVector CameraOffset = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera")
+	float RotationLagSpeed = 20.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera", meta = (ClampMin = 0.0f, ClampMax = 1.0f))
+	float Weight_FirstPerson = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Camera", meta = (ClampMin = 0.0f, ClampMax = 1.0f))
+	float Override_Debug = 0.0f;
+
+	static FCameraBehaviorParams Lerp(const FCameraBehaviorParams& A, const FCameraBehaviorParams& B, float Alpha)
+	{
+		FCameraBehaviorParams Result;
+		Result.PivotLagSpeed = FMath::Lerp(A.PivotLagSpeed, B.PivotLagSpeed, Alpha);
+		Result.PivotOffset = FMath::Lerp(A.PivotOffset, B.PivotOffset, Alpha);
+		Result.CameraOffset = FMath::Lerp(A.CameraOffset, B.CameraOffset, Alpha);
+		Result.RotationLagSpeed = FMath::Lerp(A.RotationLagSpeed, B.RotationLagSpeed, Alpha);
+		Result.Weight_FirstPerson = FMath::Lerp(A.Weight_FirstPerson, B.Weight_FirstPerson, Alpha);
+		Result.Override_Debug = FMath::Lerp(A.Override_Debug, B.Override_Debug, Alpha);
+		return Result;
+	}
+};
+
+/** Character states the camera parameters are keyed by */
+struct FCameraStateKey
+{
+	EMovementState MovementState = EMovementState::None;
+	EGait Gait = EGait::Walking;
+	EStance Stance = EStance::Standing;
+	ERotationMode RotationMode = ERotationMode::LookingDirection;
+	EViewMode ViewMode = EViewMode::ThirdPerson;
+	bool bRightShoulder = false;
+};
+
+/**
+ * Camera parameters used while the character matches this rule. An empty mask matches any value,
+ * the matching rule with the most constrained keys wins (first one on ties).
+ */
+USTRUCT(BlueprintType)
+struct FCameraStateRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (Bitmask, BitmaskEnum = "/Script/AnonLocomotion.EMovementState"))
+	int32 MovementStates = 0;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (Bitmask, BitmaskEnum = "/Script/AnonLocomotion.EGait"))
+	int32 Gaits = 0;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (Bitmask, BitmaskEnum = "/Script/AnonLocomotion.EStance"))
+	int32 Stances = 0;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (Bitmask, BitmaskEnum = "/Script/AnonLocomotion.ERotationMode"))
+	int32 RotationModes = 0;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (Bitmask, BitmaskEnum = "/Script/AnonLocomotion.EViewMode"))
+	int32 ViewModes = 0;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (InlineEditConditionToggle))
+	bool bMatchShoulder = false;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (EditCondition = "bMatchShoulder"))
+	bool bRightShoulder = true;
+
+	/** Cross-fade time when blending into this rule */
+	UPROPERTY(EditAnywhere, Category = "Camera State", meta = (ClampMin = 0.0f))
+	float BlendTime = 0.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Camera State")
+	FCameraBehaviorParams Params;
+
+	/** @return Number of constrained keys when matching, INDEX_NONE otherwise */
+	int32 Match(const FCameraStateKey& Key) const
+	{
+		int32 Specificity = 0;
+		if (!MatchMask(MovementStates, static_cast<uint8>(Key.MovementState), Specificity)
+			|| !MatchMask(Gaits, static_cast<uint8>(Key.Gait), Specificity)
+			|| !MatchMask(Stances, static_cast<uint8>(Key.Stance), Specificity)
+			|| !MatchMask(RotationModes, static_cast<uint8>(Key.RotationMode), Specificity)
+			|| !MatchMask(ViewModes, static_cast<uint8>(Key.ViewMode), Specificity))
+		{
+			return INDEX_NONE;
+		}
+
+		if (bMatchShoulder)
+		{
+			if (bRightShoulder != Key.bRightShoulder) return INDEX_NONE;
+			++Specificity;
+		}
+
+		return Specificity;
+	}
+
+private:
+	static bool MatchMask(int32 Mask, uint8 Value, int32& Specificity)
+	{
+		if (Mask == 0) return true;
+
+		++Specificity;
+		return (Mask & (1 << Value)) != 0;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct FCameraOcclusionSettings
+{
+	GENERATED_BODY()
+
+	/** Issue the sweep asynchronously and use its result next frame. Off (or running a commandlet) traces in place, deterministically */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion")
+	bool bAsyncTrace = true;
+
+	/** How fast the camera moves in front of an occluder, 0 snaps */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion", meta = (ClampMin = 0.0f))
+	float PullInSpeed = 25.0f;
+
+	/** How fast the camera returns once the occluder is gone, 0 snaps */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion", meta = (ClampMin = 0.0f))
+	float PushOutSpeed = 4.0f;
+
+	/** Cast extra rays around and ahead of the camera to start pulling in before the sweep gets blocked */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion")
+	bool bUseFeelers = true;
+
+	/** Side/up distance of the feeler ray ends from the camera target */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion", meta = (ClampMin = 0.0f, EditCondition = "bUseFeelers"))
+	float FeelerSpread = 30.0f;
+
+	/** The predictive feeler aims at where the camera target will be after this many seconds */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion", meta = (ClampMin = 0.0f, EditCondition = "bUseFeelers"))
+	float FeelerPredictionTime = 0.15f;
+
+	/** How much a feeler hit may pull the camera in, 1 treats it like a sweep hit */
+	UPROPERTY(EditAnywhere, Category = "Camera Occlusion", meta = (ClampMin = 0.0f, ClampMax = 1.0f, EditCondition = "bUseFeelers"))
+	float FeelerInfluence = 0.5f;
+};
@@ -0,0 +1,47 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocomotionEnum.h"
+
+/** Stable reference to a crowd agent, stays valid while the agent switches between simulation and actor */
+struct FAnonCrowdAgentHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	FORCEINLINE bool IsValid() const { return Index != INDEX_NONE; }
+	FORCEINLINE void Invalidate() { Index = INDEX_NONE; }
+};
+
+/**
+ * Locomotion state of one crowd agent, what is left of a character once its actor is gone. Agents of a world are
+ * stored contiguously and simulated in batches, members are ordered largest first to keep them tightly packed.
+ */
+struct FAnonCrowdAgent
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	/** Desired movement direction scaled by the input amount (0-1), same as the movement input of a character */
+	FVector MovementInput = FVector::ZeroVector;
+
+	FRotator Rotation = FRotator::ZeroRotator;
+	FRotator TargetRotation = FRotator::ZeroRotator;
+	FRotator AimingRotation = FRotator::ZeroRotator;
+
+	float Speed = 0.0f;
+
+	/** Shared movement data of the agent's character class, see UAnonCrowdSubsystem */
+	int32 ArchetypeIndex = INDEX_NONE;
+	uint32 Serial = 0;
+
+	EGait DesiredGait = EGait::Running;
+	EGait Gait = EGait::Walking;
+	EStance Stance = EStance::Standing;
+	ERotationMode RotationMode = ERotationMode::VelocityDirection;
+
+	bool bActive = false;
+	/** Simulated by a pooled character actor instead of the batch */
+	bool bHydrated = false;
+};
@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionEnum.h"
+#include "Engine/EngineTypes.h"
+#include "Kismet/KismetSystemLibrary.h"
+
+struct FHitFX;
+class UDataTable;
+class UPhysicalMaterial;
+class USkeletalMeshComponent;
+class UPrimitiveComponent;
+
+/**
+ * One footstep, queued by the notify with only the mesh, socket and settings. The FX subsystem traces for the ground
+ * (or reuses the foot IK hit) and fills in the rest before playing it.
+ */
+struct FFootstepFXRequest
+{
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+	FName FootSocketName;
+
+	TWeakObjectPtr<const UDataTable> Table;
+	ECollisionChannel TraceChannel = ECC_Visibility;
+	float TraceLength = 50.0f;
+	EDrawDebugTrace::Type DrawDebugType = EDrawDebugTrace::None;
+
+	//-- Filled once the ground hit is resolved --//
+	const FHitFX* HitFX = nullptr;
+	FVector HitLocation = FVector::ZeroVector;
+	TWeakObjectPtr<UPrimitiveComponent> HitComponent;
+	FRotator FootRotation = FRotator::ZeroRotator;
+	FTransform OwnerTransform = FTransform::Identity;
+
+	FName SoundParameterName;
+	EFootstepType FootstepType = EFootstepType::Step;
+	float VolumeMultiplier = 1.0f;
+	float PitchMultiplier = 1.0f;
+
+	/** Sign of each decal axis, -1 mirrors it */
+	FVector DecalScale = FVector::OneVector;
+
+	bool bSpawnSound = false;
+	bool bSpawnNiagara = false;
+	bool bSpawnDecal = false;
+
+	//-- Filled by significance --//
+	float DistanceToListener = 0.0f;
+	bool bVisible = true;
+
+	/** 0..1, closer and on screen is higher. Decides who gets the frame's budget and the audio priority */
+	float Significance = 1.0f;
+};
+
+/** Ground under a foot found by the foot IK trace, lets footsteps skip their own trace */
+struct FFootGroundHit
+{
+	FVector Location = FVector::ZeroVector;
+	TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	/** World time of the trace, negative until the foot traced once */
+	double Time = -1.0;
+};
@@ -0,0 +1,198 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocomotionEnum.h"
+#include "LocomotionNetStruct.generated.h"
+
+/**
+ * Movement input and control rotation sent to simulated proxies, stored already quantized:
+ * acceleration as a yaw/pitch direction plus an 8-bit magnitude relative to max acceleration,
+ * control rotation as 16-bit yaw/pitch. Update() only touches the fields when the new values moved past a threshold,
+ * so the property stays clean (and unsent) while the input is steady.
+ */
+USTRUCT()
+struct FReplicatedLocomotionInput
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 AccelerationAmount = 0;
+
+	UPROPERTY()
+	uint16 AccelerationYaw = 0;
+
+	UPROPERTY()
+	uint16 AccelerationPitch = 0;
+
+	UPROPERTY()
+	uint16 ControlYaw = 0;
+
+	UPROPERTY()
+	uint16 ControlPitch = 0;
+
+	/**
+	 * Quantize and store new values.
+	 * @param AmountThreshold Minimum change of Acceleration / MaxAcceleration (0..1) to be written
+	 * @param AngleThreshold Minimum change in degrees of either direction or control rotation to be written
+	 * @return Whether any field was written
+	 */
+	bool Update(const FVector& Acceleration, float MaxAcceleration, const FRotator& ControlRotation,
+	            float AmountThreshold, float AngleThreshold)
+	{
+		const uint16 AngleThresholdShort = FMath::Max<uint16>(1, FRotator::CompressAxisToShort(AngleThreshold));
+
+		const float Amount = MaxAcceleration > 0.0f ? FMath::Clamp(Acceleration.Size() / MaxAcceleration, 0.0f, 1.0f) : 0.0f;
+		const uint8 NewAmount = FMath::RoundToInt(Amount * MAX_uint8);
+		const bool bAmountChanged = NewAmount != AccelerationAmount
+			&& (NewAmount == 0 || FMath::Abs(NewAmount - AccelerationAmount) >= FMath::Max(1, FMath::RoundToInt(AmountThreshold * MAX_uint8)));
+
+		bool bChanged = bAmountChanged;
+		if (bAmountChanged)
+		{
+			AccelerationAmount = NewAmount;
+		}
+
+		if (AccelerationAmount != 0)
+		{
+			const FRotator Direction = Acceleration.ToOrientationRotator();
+			const uint16 NewYaw = FRotator::CompressAxisToShort(Direction.Yaw);
+			const uint16 NewPitch = FRotator::CompressAxisToShort(Direction.Pitch);
+			if (bAmountChanged || ShortAngleDelta(NewYaw, AccelerationYaw) >= AngleThresholdShort
+				|| ShortAngleDelta(NewPitch, AccelerationPitch) >= AngleThresholdShort)
+			{
+				bChanged |= NewYaw != AccelerationYaw || NewPitch != AccelerationPitch;
+				AccelerationYaw = NewYaw;
+				AccelerationPitch = NewPitch;
+			}
+		}
+
+		const uint16 NewControlYaw = FRotator::CompressAxisToShort(ControlRotation.Yaw);
+		const uint16 NewControlPitch = FRotator::CompressAxisToShort(ControlRotation.Pitch);
+		if (ShortAngleDelta(NewControlYaw, ControlYaw) >= AngleThresholdShort
+			|| ShortAngleDelta(NewControlPitch, ControlPitch) >= AngleThresholdShort)
+		{
+			ControlYaw = NewControlYaw;
+			ControlPitch = NewControlPitch;
+			bChanged = true;
+		}
+
+		return bChanged;
+	}
+
+	/** Reconstruct the acceleration on the receiving side, scaled by its own max acceleration */
+	FVector GetAcceleration(float MaxAcceleration) const
+	{
+		if (AccelerationAmount == 0) return FVector::ZeroVector;
+
+		const FRotator Direction(FRotator::DecompressAxisFromShort(AccelerationPitch),
+		                         FRotator::DecompressAxisFromShort(AccelerationYaw), 0.0f);
+		return Direction.Vector() * (AccelerationAmount / static_cast<float>(MAX_uint8) * MaxAcceleration);
+	}
+
+	FRotator GetControlRotation() const
+	{
+		return {FRotator::DecompressAxisFromShort(ControlPitch), FRotator::DecompressAxisFromShort(ControlYaw), 0.0f};
+	}
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+	{
+		// Direction is skipped entirely while there is no movement input
+		uint8 bHasAcceleration = AccelerationAmount != 0;
+		Ar.SerializeBits(&bHasAcceleration, 1);
+		if (bHasAcceleration)
+		{
+			Ar << AccelerationAmount;
+			Ar << AccelerationYaw;
+			Ar << AccelerationPitch;
+		}
+		else if (Ar.IsLoading())
+		{
+			AccelerationAmount = 0;
+		}
+
+		Ar << ControlYaw;
+		Ar << ControlPitch;
+
+		bOutSuccess = true;
+		return true;
+	}
+
+	bool operator==(const FReplicatedLocomotionInput& Other) const
+	{
+		return AccelerationAmount == Other.AccelerationAmount && AccelerationYaw == Other.AccelerationYaw
+			&& AccelerationPitch == Other.AccelerationPitch && ControlYaw == Other.ControlYaw
+			&& ControlPitch == Other.ControlPitch;
+	}
+
+private:
+	static uint16 ShortAngleDelta(uint16 A, uint16 B)
+	{
+		return static_cast<uint16>(FMath::Abs(static_cast<int16>(A - B)));
+	}
+};
+
+/**
+ * Discrete locomotion intents of the owning client. Sent with every movement packet (see UAnonCharacterMovement)
+ * instead of one reliable RPC per toggle, so they are ordered with movement and cost no extra RPCs.
+ */
+struct FLocomotionIntent
+{
+	EStance DesiredStance = EStance::Standing;
+	EGait DesiredGait = EGait::Running;
+	ERotationMode RotationMode = ERotationMode::LookingDirection;
+	ERotationMode DesiredRotationMode = ERotationMode::LookingDirection;
+	EViewMode ViewMode = EViewMode::ThirdPerson;
+	EOverlayState OverlayState = EOverlayState::Default;
+
+	/** 12 bits: stance 1, gait 2, rotation modes 2 + 2, view mode 1, overlay state 4 */
+	void Serialize(FArchive& Ar)
+	{
+		uint32 Packed = 0;
+		if (!Ar.IsLoading())
+		{
+			Packed = static_cast<uint32>(DesiredStance)
+				| static_cast<uint32>(DesiredGait) << 1
+				| static_cast<uint32>(RotationMode) << 3
+				| static_cast<uint32>(DesiredRotationMode) << 5
+				| static_cast<uint32>(ViewMode) << 7
+				| static_cast<uint32>(OverlayState) << 8;
+		}
+
+		Ar.SerializeBits(&Packed, 12);
+
+		if (Ar.IsLoading())
+		{
+			// Clamp what the bit widths allow beyond the last enum value, these come straight from the client
+			DesiredStance = static_cast<EStance>(Packed & 0x1);
+			DesiredGait = static_cast<EGait>(FMath::Min(Packed >> 1 & 0x3, static_cast<uint32>(EGait::Sprinting)));
+			RotationMode = static_cast<ERotationMode>(FMath::Min(Packed >> 3 & 0x3,
+			                                                     static_cast<uint32>(ERotationMode::Aiming)));
+			DesiredRotationMode = static_cast<ERotationMode>(FMath::Min(Packed >> 5 & 0x3,
+			                                                            static_cast<uint32>(ERotationMode::Aiming)));
+			ViewMode = static_cast<EViewMode>(Packed >> 7 & 0x1);
+			OverlayState = static_cast<EOverlayState>(FMath::Min(Packed >> 8 & 0xF,
+			                                                     static_cast<uint32>(EOverlayState::Barrel)));
+		}
+	}
+
+	bool operator==(const FLocomotionIntent& Other) const
+	{
+		return DesiredStance == Other.DesiredStance && DesiredGait == Other.DesiredGait
+			&& RotationMode == Other.RotationMode && DesiredRotationMode == Other.DesiredRotationMode
+			&& ViewMode == Other.ViewMode && OverlayState == Other.OverlayState;
+	}
+
+	bool operator!=(const FLocomotionIntent& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FReplicatedLocomotionInput> : public TStructOpsTypeTraitsBase2<FReplicatedLocomotionInput>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
@@ -0,0 +1,49 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocomotionEnum.h"
+
+/**
+ * Hot per-frame locomotion state of a character. Kept free of UObject references and config so it can live in the
+ * world-owned contiguous pool (see ULocomotionStateSubsystem) and be batch-processed or snapshotted cheaply.
+ * Members are ordered largest first to keep the block tightly packed.
+ */
+struct FLocomotionRuntimeState
+{
+	FVector Acceleration = FVector::ZeroVector;
+	FVector PreviousVelocity = FVector::ZeroVector;
+
+	FRotator LastVelocityRotation = FRotator::ZeroRotator;
+	FRotator LastMovementInputRotation = FRotator::ZeroRotator;
+	FRotator AimingRotation = FRotator::ZeroRotator;
+	FRotator TargetRotation = FRotator::ZeroRotator;
+
+	float Speed = 0.0f;
+	float MovementInputAmount = 0.0f;
+	float AimYawRate = 0.0f;
+	float PreviousAimYaw = 0.0f;
+	float EasedMaxAcceleration = 0.0f;
+
+	/** Bumped whenever a discrete state changes so readers can skip copying them on quiet frames */
+	uint32 StateVersion = 0;
+
+	EMovementState MovementState = EMovementState::None;
+	EMovementState PrevMovementState = EMovementState::None;
+	EGait Gait = EGait::Walking;
+	EStance Stance = EStance::Standing;
+	ERotationMode RotationMode = ERotationMode::LookingDirection;
+
+	bool bIsMoving = false;
+	bool bHasMovementInput = false;
+};
+
+/** Index of a runtime state block inside the world pool */
+struct FLocomotionStateHandle
+{
+	int32 Index = INDEX_NONE;
+
+	FORCEINLINE bool IsValid() const { return Index != INDEX_NONE; }
+	FORCEINLINE void Invalidate() { Index = INDEX_NONE; }
+};
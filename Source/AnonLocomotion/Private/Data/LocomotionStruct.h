@@ -4,6 +4,8 @@
 #include "LocomotionEnum.h"
 #include "LocomotionStruct.generated.h"
 
+class UAnimInstance;
+class UAnimMontage;
 class UCurveVector;
 class UAnimSequenceBase;
 class UCurveFloat;
@@ -636,3 +638,25 @@ struct FAnimConfiguration
 	float IK_TraceDistanceBelowFoot = 45.f;
 };
 
+/** Montage window that stops early once the character reaches one of the conditions, see UNotifyState_EarlyBlendOut */
+struct FEarlyBlendOutCondition
+{
+	/** Notify that registered the window, used to unregister it again */
+	TObjectKey<UObject> Source;
+
+	TWeakObjectPtr<UAnimInstance> AnimInstance;
+
+	/** Montage to stop, windows without one are not registered */
+	TWeakObjectPtr<UAnimMontage> Montage;
+
+	float BlendOutTime = 0.25f;
+
+	bool bCheckMovementState = false;
+	EMovementState MovementStateEquals = EMovementState::None;
+
+	bool bCheckStance = false;
+	EStance StanceEquals = EStance::Standing;
+
+	bool bCheckMovementInput = false;
+};
+
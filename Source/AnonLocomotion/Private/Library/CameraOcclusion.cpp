@@ -0,0 +1,149 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/CameraOcclusion.h"
+
+#include "Engine/World.h"
+#include "Library/LocomotionProfiling.h"
+
+FVector FCameraOcclusion::Update(UWorld& World, const FCameraOcclusionSettings& Settings, const FVector& Origin,
+                                 const FVector& Target, const FRotationMatrix& CameraMatrix, float Radius,
+                                 ECollisionChannel Channel, const FCollisionQueryParams& QueryParams, float DeltaTime)
+{
+	if (bHasPreviousTarget && DeltaTime > 0.0f)
+	{
+		TargetVelocity = (Target - PreviousTarget) / DeltaTime;
+	}
+	PreviousTarget = Target;
+	bHasPreviousTarget = true;
+
+	// Commandlets (headless replays) always trace in place so results don't depend on frame timing
+	if (Settings.bAsyncTrace && !IsRunningCommandlet())
+	{
+		float AsyncFraction;
+		if (ConsumeAsync(World, Settings, AsyncFraction))
+		{
+			DesiredFraction = AsyncFraction;
+		}
+		TraceAsync(World, Settings, Origin, Target, CameraMatrix, Radius, Channel, QueryParams);
+	}
+	else
+	{
+		DesiredFraction = TraceSync(World, Settings, Origin, Target, CameraMatrix, Radius, Channel, QueryParams);
+	}
+
+	const float Speed = DesiredFraction < SmoothedFraction ? Settings.PullInSpeed : Settings.PushOutSpeed;
+	SmoothedFraction = Speed > 0.0f ? FMath::FInterpTo(SmoothedFraction, DesiredFraction, DeltaTime, Speed) : DesiredFraction;
+
+	return Origin + (Target - Origin) * SmoothedFraction;
+}
+
+void FCameraOcclusion::Reset()
+{
+	SweepHandle = FTraceHandle();
+	for (FTraceHandle& Handle : FeelerHandles)
+	{
+		Handle = FTraceHandle();
+	}
+
+	bHasPreviousTarget = false;
+	TargetVelocity = FVector::ZeroVector;
+	DesiredFraction = 1.0f;
+	SmoothedFraction = 1.0f;
+}
+
+void FCameraOcclusion::GetFeelerTargets(const FCameraOcclusionSettings& Settings, const FVector& Target,
+                                        const FRotationMatrix& CameraMatrix, FVector (&OutTargets)[NumFeelers]) const
+{
+	const FVector Right = CameraMatrix.GetScaledAxis(EAxis::Y) * Settings.FeelerSpread;
+	const FVector Up = CameraMatrix.GetScaledAxis(EAxis::Z) * Settings.FeelerSpread;
+
+	OutTargets[0] = Target + TargetVelocity * Settings.FeelerPredictionTime;
+	OutTargets[1] = Target + Right;
+	OutTargets[2] = Target - Right;
+	OutTargets[3] = Target + Up;
+	OutTargets[4] = Target - Up;
+}
+
+float FCameraOcclusion::TraceSync(UWorld& World, const FCameraOcclusionSettings& Settings, const FVector& Origin,
+                                  const FVector& Target, const FRotationMatrix& CameraMatrix, float Radius,
+                                  ECollisionChannel Channel, const FCollisionQueryParams& QueryParams) const
+{
+	float Fraction = 1.0f;
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, Settings.bUseFeelers ? 1 + NumFeelers : 1);
+	FHitResult HitResult;
+	if (World.SweepSingleByChannel(HitResult, Origin, Target, FQuat::Identity, Channel,
+	                               FCollisionShape::MakeSphere(Radius), QueryParams))
+	{
+		Fraction = HitResult.Time;
+	}
+
+	if (Settings.bUseFeelers)
+	{
+		FVector FeelerTargets[NumFeelers];
+		GetFeelerTargets(Settings, Target, CameraMatrix, FeelerTargets);
+		for (const FVector& FeelerTarget : FeelerTargets)
+		{
+			if (World.LineTraceSingleByChannel(HitResult, Origin, FeelerTarget, Channel, QueryParams))
+			{
+				Fraction = CombineFeeler(Settings, Fraction, HitResult.Time);
+			}
+		}
+	}
+
+	return Fraction;
+}
+
+void FCameraOcclusion::TraceAsync(UWorld& World, const FCameraOcclusionSettings& Settings, const FVector& Origin,
+                                  const FVector& Target, const FRotationMatrix& CameraMatrix, float Radius,
+                                  ECollisionChannel Channel, const FCollisionQueryParams& QueryParams)
+{
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, Settings.bUseFeelers ? 1 + NumFeelers : 1);
+	SweepHandle = World.AsyncSweepByChannel(EAsyncTraceType::Single, Origin, Target, FQuat::Identity, Channel,
+	                                        FCollisionShape::MakeSphere(Radius), QueryParams);
+
+	if (!Settings.bUseFeelers) return;
+
+	FVector FeelerTargets[NumFeelers];
+	GetFeelerTargets(Settings, Target, CameraMatrix, FeelerTargets);
+	for (int32 i = 0; i < NumFeelers; ++i)
+	{
+		FeelerHandles[i] = World.AsyncLineTraceByChannel(EAsyncTraceType::Single, Origin, FeelerTargets[i], Channel,
+		                                                 QueryParams);
+	}
+}
+
+bool FCameraOcclusion::ConsumeAsync(UWorld& World, const FCameraOcclusionSettings& Settings, float& OutFraction)
+{
+	FTraceDatum Datum;
+	if (!SweepHandle.IsValid() || !World.QueryTraceData(SweepHandle, Datum))
+	{
+		return false;
+	}
+
+	OutFraction = 1.0f;
+	if (Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+	{
+		OutFraction = Datum.OutHits[0].Time;
+	}
+
+	if (Settings.bUseFeelers)
+	{
+		for (const FTraceHandle& Handle : FeelerHandles)
+		{
+			if (Handle.IsValid() && World.QueryTraceData(Handle, Datum) && Datum.OutHits.Num() > 0 &&
+				Datum.OutHits[0].bBlockingHit)
+			{
+				OutFraction = CombineFeeler(Settings, OutFraction, Datum.OutHits[0].Time);
+			}
+		}
+	}
+
+	return true;
+}
+
+float FCameraOcclusion::CombineFeeler(const FCameraOcclusionSettings& Settings, float Fraction, float FeelerTime)
+{
+	// A feeler only sees an occluder near the camera path, let it pull in partially
+	return FMath::Min(Fraction, FMath::Lerp(1.0f, FeelerTime, Settings.FeelerInfluence));
+}
@@ -0,0 +1,56 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/CameraStruct.h"
+#include "WorldCollision.h"
+
+/**
+ * Keeps the camera in front of anything between the trace origin and the camera target.
+ * Works on the fraction of the origin -> target segment that is free, so an async result from last frame still
+ * applies to this frame's segment. Pull-in and push-out are smoothed separately to avoid pops.
+ */
+class FCameraOcclusion
+{
+public:
+	/** @return Camera target moved in front of the occluders */
+	FVector Update(UWorld& World, const FCameraOcclusionSettings& Settings, const FVector& Origin, const FVector& Target,
+	               const FRotationMatrix& CameraMatrix, float Radius, ECollisionChannel Channel,
+	               const FCollisionQueryParams& QueryParams, float DeltaTime);
+
+	/** Forget pending traces and smoothing, e.g. after a possession change */
+	void Reset();
+
+	FORCEINLINE float GetFreeFraction() const { return SmoothedFraction; }
+
+private:
+	static constexpr int32 NumFeelers = 5;
+
+	/** Feeler ray ends: ahead along the camera motion, then right/left/up/down of the target */
+	void GetFeelerTargets(const FCameraOcclusionSettings& Settings, const FVector& Target,
+	                      const FRotationMatrix& CameraMatrix, FVector (&OutTargets)[NumFeelers]) const;
+
+	float TraceSync(UWorld& World, const FCameraOcclusionSettings& Settings, const FVector& Origin, const FVector& Target,
+	                const FRotationMatrix& CameraMatrix, float Radius, ECollisionChannel Channel,
+	                const FCollisionQueryParams& QueryParams) const;
+
+	void TraceAsync(UWorld& World, const FCameraOcclusionSettings& Settings, const FVector& Origin, const FVector& Target,
+	                const FRotationMatrix& CameraMatrix, float Radius, ECollisionChannel Channel,
+	                const FCollisionQueryParams& QueryParams);
+
+	/** Read last frame's async results. @return false while they are not available yet */
+	bool ConsumeAsync(UWorld& World, const FCameraOcclusionSettings& Settings, float& OutFraction);
+
+	static float CombineFeeler(const FCameraOcclusionSettings& Settings, float Fraction, float FeelerTime);
+
+	FTraceHandle SweepHandle;
+	FTraceHandle FeelerHandles[NumFeelers];
+
+	FVector PreviousTarget = FVector::ZeroVector;
+	FVector TargetVelocity = FVector::ZeroVector;
+	bool bHasPreviousTarget = false;
+
+	float DesiredFraction = 1.0f;
+	float SmoothedFraction = 1.0f;
+};
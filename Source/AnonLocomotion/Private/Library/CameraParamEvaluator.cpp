@@ -0,0 +1,49 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/CameraParamEvaluator.h"
+
+#include "Camera/AnonCameraSettings.h"
+
+void FCameraParamEvaluator::Reset(const UAnonCameraSettings& Settings, const FCameraStateKey& Key)
+{
+	SetTarget(Settings, Key);
+	CurrentParams = TargetParams;
+	FromParams = TargetParams;
+	BlendAlpha = 1.0f;
+}
+
+const FCameraBehaviorParams& FCameraParamEvaluator::Update(const UAnonCameraSettings& Settings,
+                                                           const FCameraStateKey& Key, bool bKeyChanged,
+                                                           float DeltaTime)
+{
+	if (bKeyChanged)
+	{
+		// Start the new fade from wherever the previous one currently is
+		FromParams = CurrentParams;
+		SetTarget(Settings, Key);
+		BlendAlpha = 0.0f;
+	}
+
+	if (BlendAlpha < 1.0f)
+	{
+		BlendAlpha = BlendTime > 0.0f ? FMath::Min(BlendAlpha + DeltaTime / BlendTime, 1.0f) : 1.0f;
+		CurrentParams = FCameraBehaviorParams::Lerp(FromParams, TargetParams,
+		                                            FMath::SmoothStep(0.0f, 1.0f, BlendAlpha));
+	}
+
+	return CurrentParams;
+}
+
+void FCameraParamEvaluator::SetTarget(const UAnonCameraSettings& Settings, const FCameraStateKey& Key)
+{
+	if (const FCameraStateRule* Rule = Settings.FindRule(Key))
+	{
+		TargetParams = Rule->Params;
+		BlendTime = Rule->BlendTime;
+	}
+	else
+	{
+		TargetParams = Settings.DefaultParams;
+		BlendTime = Settings.DefaultBlendTime;
+	}
+}
@@ -0,0 +1,35 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/CameraStruct.h"
+
+class UAnonCameraSettings;
+
+/**
+ * Produces the camera behavior parameters from UAnonCameraSettings, cross-fading between rules when the
+ * character state changes. Replaces the hidden skeletal mesh + anim graph, no pose is evaluated.
+ */
+class FCameraParamEvaluator
+{
+public:
+	/** Snap to the rule matching Key without blending */
+	void Reset(const UAnonCameraSettings& Settings, const FCameraStateKey& Key);
+
+	/** Re-resolve the target rule when bKeyChanged and advance the cross-fade */
+	const FCameraBehaviorParams& Update(const UAnonCameraSettings& Settings, const FCameraStateKey& Key,
+	                                    bool bKeyChanged, float DeltaTime);
+
+	FORCEINLINE const FCameraBehaviorParams& GetParams() const { return CurrentParams; }
+
+private:
+	void SetTarget(const UAnonCameraSettings& Settings, const FCameraStateKey& Key);
+
+	FCameraBehaviorParams CurrentParams;
+	FCameraBehaviorParams FromParams;
+	FCameraBehaviorParams TargetParams;
+
+	float BlendTime = 0.0f;
+	float BlendAlpha = 1.0f;
+};
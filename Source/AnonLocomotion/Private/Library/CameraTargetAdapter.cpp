@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/CameraTargetAdapter.h"
+
+#include "Characters/AnonCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMeshSocket.h"
+
+const FName FCameraTargetSockets::FirstPersonCamera(TEXT("FP_Camera"));
+const FName FCameraTargetSockets::Head(TEXT("Head"));
+const FName FCameraTargetSockets::Root(TEXT("root"));
+const FName FCameraTargetSockets::TraceLeft(TEXT("TP_CameraTrace_L"));
+const FName FCameraTargetSockets::TraceRight(TEXT("TP_CameraTrace_R"));
+
+/** A subclass overriding the target getters returns something else than the base getters do */
+static bool OverridesCameraTargets(AAnonCharacter& Character)
+{
+	FVector TraceOrigin, BaseTraceOrigin;
+	float TraceRadius = 0.0f, BaseTraceRadius = 0.0f;
+	const ECollisionChannel TraceChannel = Character.GetThirdPersonTraceParams(TraceOrigin, TraceRadius);
+	const ECollisionChannel BaseTraceChannel =
+		Character.AAnonCharacter::GetThirdPersonTraceParams(BaseTraceOrigin, BaseTraceRadius);
+
+	return TraceChannel != BaseTraceChannel || TraceRadius != BaseTraceRadius || !TraceOrigin.Equals(BaseTraceOrigin)
+		|| !Character.GetThirdPersonPivotTarget().Equals(Character.AAnonCharacter::GetThirdPersonPivotTarget())
+		|| !Character.GetFirstPersonCameraTarget().Equals(Character.AAnonCharacter::GetFirstPersonCameraTarget());
+}
+
+void FCameraTargetAdapter::Initialize(AAnonCharacter& InCharacter)
+{
+	Character = &InCharacter;
+	Mesh = InCharacter.GetMesh();
+
+	Head.Name = FCameraTargetSockets::Head;
+	Root.Name = FCameraTargetSockets::Root;
+	FirstPersonCamera.Name = FCameraTargetSockets::FirstPersonCamera;
+	TraceRight.Name = FCameraTargetSockets::TraceRight;
+	TraceLeft.Name = FCameraTargetSockets::TraceLeft;
+
+	bCustomTargets = InCharacter.HasCustomCameraTargets() || OverridesCameraTargets(InCharacter);
+
+	// Radius and channel of the default targets don't change per frame, custom ones are read in Evaluate
+	FVector UnusedOrigin;
+	TraceChannel = InCharacter.GetThirdPersonTraceParams(UnusedOrigin, TraceRadius);
+
+	ResolvedAsset.Reset();
+	ResolveSockets();
+}
+
+void FCameraTargetAdapter::Reset()
+{
+	Character.Reset();
+	Mesh.Reset();
+	ResolvedAsset.Reset();
+}
+
+void FCameraTargetAdapter::Evaluate(FCameraTargetPoints& OutPoints)
+{
+	USkeletalMeshComponent* MeshComp = Mesh.Get();
+	if (!MeshComp || !Character.IsValid()) return;
+
+	if (bCustomTargets)
+	{
+		OutPoints.PivotTarget = Character->GetThirdPersonPivotTarget();
+		OutPoints.FirstPersonTarget = Character->GetFirstPersonCameraTarget();
+		OutPoints.TraceChannel = Character->GetThirdPersonTraceParams(OutPoints.TraceOrigin, OutPoints.TraceRadius);
+		return;
+	}
+
+	if (ResolvedAsset.Get() != MeshComp->GetSkeletalMeshAsset())
+	{
+		ResolveSockets();
+	}
+
+	const TArray<FTransform>& ComponentSpaceTransforms = MeshComp->GetComponentSpaceTransforms();
+	const FTransform& ComponentTransform = MeshComp->GetComponentTransform();
+
+	const FVector HeadLocation = GetSocketLocation(Head, ComponentSpaceTransforms, ComponentTransform);
+	const FVector RootLocation = GetSocketLocation(Root, ComponentSpaceTransforms, ComponentTransform);
+	OutPoints.PivotTarget = FTransform(Character->GetActorQuat(), (HeadLocation + RootLocation) / 2.0f);
+	OutPoints.FirstPersonTarget = GetSocketLocation(FirstPersonCamera, ComponentSpaceTransforms, ComponentTransform);
+	OutPoints.TraceOrigin = GetSocketLocation(Character->IsRightShoulder() ? TraceRight : TraceLeft,
+	                                          ComponentSpaceTransforms, ComponentTransform);
+	OutPoints.TraceRadius = TraceRadius;
+	OutPoints.TraceChannel = TraceChannel;
+}
+
+void FCameraTargetAdapter::ResolveSockets()
+{
+	const USkeletalMeshComponent* MeshComp = Mesh.Get();
+	ResolvedAsset = MeshComp ? MeshComp->GetSkeletalMeshAsset() : nullptr;
+
+	ResolveSocket(Head);
+	ResolveSocket(Root);
+	ResolveSocket(FirstPersonCamera);
+	ResolveSocket(TraceRight);
+	ResolveSocket(TraceLeft);
+}
+
+void FCameraTargetAdapter::ResolveSocket(FResolvedSocket& Socket) const
+{
+	Socket.BoneIndex = INDEX_NONE;
+	Socket.LocalTransform = FTransform::Identity;
+
+	const USkeletalMeshComponent* MeshComp = Mesh.Get();
+	if (!MeshComp) return;
+
+	// Same lookup order as USkeletalMeshComponent::GetSocketTransform: sockets first, then bones
+	if (const USkeletalMeshSocket* MeshSocket = MeshComp->GetSocketByName(Socket.Name))
+	{
+		Socket.BoneIndex = MeshComp->GetBoneIndex(MeshSocket->BoneName);
+		Socket.LocalTransform = MeshSocket->GetSocketLocalTransform();
+	}
+	else
+	{
+		Socket.BoneIndex = MeshComp->GetBoneIndex(Socket.Name);
+	}
+}
+
+FVector FCameraTargetAdapter::GetSocketLocation(const FResolvedSocket& Socket,
+                                                const TArray<FTransform>& ComponentSpaceTransforms,
+                                                const FTransform& ComponentTransform) const
+{
+	if (!ComponentSpaceTransforms.IsValidIndex(Socket.BoneIndex))
+	{
+		// Unresolved (missing socket, mesh not ready yet), let the component handle it
+		return Mesh->GetSocketLocation(Socket.Name);
+	}
+
+	const FVector ComponentSpaceLocation =
+		ComponentSpaceTransforms[Socket.BoneIndex].TransformPosition(Socket.LocalTransform.GetLocation());
+	return ComponentTransform.TransformPosition(ComponentSpaceLocation);
+}
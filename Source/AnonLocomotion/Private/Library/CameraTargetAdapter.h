@@ -0,0 +1,76 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AAnonCharacter;
+class USkeletalMeshComponent;
+class USkinnedAsset;
+
+/** Sockets the default camera targets are read from, shared with AAnonCharacter's camera getters */
+struct FCameraTargetSockets
+{
+	static const FName FirstPersonCamera;
+	static const FName Head;
+	static const FName Root;
+	static const FName TraceLeft;
+	static const FName TraceRight;
+};
+
+/** Camera inputs of one frame, everything the camera reads from its target */
+struct FCameraTargetPoints
+{
+	FTransform PivotTarget = FTransform::Identity;
+	FVector FirstPersonTarget = FVector::ZeroVector;
+	FVector TraceOrigin = FVector::ZeroVector;
+	float TraceRadius = 15.0f;
+	ECollisionChannel TraceChannel = ECC_Camera;
+};
+
+/**
+ * Per view target cache built at possession. Resolves the pivot (Head/root), first person and trace sockets to bone
+ * indices once, then reads all of them from a single pass over the component space transforms each frame. Characters
+ * overriding the virtual camera target getters, or with bCustomCameraTargets, are asked through the getters every
+ * frame instead.
+ */
+class FCameraTargetAdapter
+{
+public:
+	void Initialize(AAnonCharacter& InCharacter);
+	void Reset();
+
+	/** Cheap per frame check replacing the view target type test */
+	FORCEINLINE bool IsValidFor(const AActor* Target) const { return Target && Target == Character.Get(); }
+
+	void Evaluate(FCameraTargetPoints& OutPoints);
+
+private:
+	struct FResolvedSocket
+	{
+		FName Name;
+		int32 BoneIndex = INDEX_NONE;
+		FTransform LocalTransform = FTransform::Identity;
+	};
+
+	/** Re-resolve bone indices when the mesh asset got swapped (e.g. visible mesh change) */
+	void ResolveSockets();
+	void ResolveSocket(FResolvedSocket& Socket) const;
+	FVector GetSocketLocation(const FResolvedSocket& Socket, const TArray<FTransform>& ComponentSpaceTransforms,
+	                          const FTransform& ComponentTransform) const;
+
+	TWeakObjectPtr<AAnonCharacter> Character;
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+	TWeakObjectPtr<const USkinnedAsset> ResolvedAsset;
+
+	FResolvedSocket Head;
+	FResolvedSocket Root;
+	FResolvedSocket FirstPersonCamera;
+	FResolvedSocket TraceRight;
+	FResolvedSocket TraceLeft;
+
+	float TraceRadius = 15.0f;
+	ECollisionChannel TraceChannel = ECC_Camera;
+
+	bool bCustomTargets = false;
+};
@@ -0,0 +1,126 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/FootstepSurfaceCache.h"
+
+#include "Data/LocomotionStruct.h"
+#include "Engine/DataTable.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectGlobals.h"
+
+FRWLock FFootstepSurfaceCache::Lock;
+TMap<TObjectKey<UDataTable>, FFootstepSurfaceCache::FSurfaceRows> FFootstepSurfaceCache::Tables;
+FDelegateHandle FFootstepSurfaceCache::PostGarbageCollectHandle;
+
+const FHitFX* FFootstepSurfaceCache::Find(const UDataTable* Table, EPhysicalSurface Surface)
+{
+	if (!Table || Surface >= SurfaceType_Max) return nullptr;
+
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const FSurfaceRows* Found = Tables.Find(Table))
+		{
+			return Found->Rows[Surface];
+		}
+	}
+
+	// Building binds the table's change delegate, which is game thread only. Tables are primed when registered
+	if (!IsInGameThread()) return nullptr;
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have built it while we waited for the write lock
+	if (const FSurfaceRows* Found = Tables.Find(Table))
+	{
+		return Found->Rows[Surface];
+	}
+	return Build(Table).Rows[Surface];
+}
+
+void FFootstepSurfaceCache::Prime(const UDataTable* Table)
+{
+	check(IsInGameThread());
+	if (!Table) return;
+
+	FWriteScopeLock WriteLock(Lock);
+	if (!Tables.Contains(Table))
+	{
+		Build(Table);
+	}
+}
+
+void FFootstepSurfaceCache::Invalidate(const UDataTable* Table)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	FSurfaceRows Removed;
+	if (Tables.RemoveAndCopyValue(Table, Removed))
+	{
+		const_cast<UDataTable*>(Table)->OnDataTableChanged().Remove(Removed.ChangedHandle);
+	}
+}
+
+void FFootstepSurfaceCache::RemoveCollectedTables()
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	// Rows of a collected table point into its freed row map
+	for (auto It = Tables.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+FFootstepSurfaceCache::FSurfaceRows& FFootstepSurfaceCache::Build(const UDataTable* Table)
+{
+	check(IsInGameThread());
+
+	if (!PostGarbageCollectHandle.IsValid())
+	{
+		PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&RemoveCollectedTables);
+	}
+
+	FSurfaceRows& OutRows = Tables.Add(Table);
+
+	// Rows point into the table's row map, which an edit or reimport rebuilds
+	TWeakObjectPtr<const UDataTable> WeakTable = Table;
+	OutRows.ChangedHandle = const_cast<UDataTable*>(Table)->OnDataTableChanged().AddLambda([WeakTable]()
+	{
+		Invalidate(WeakTable.Get());
+	});
+
+	if (Table->GetRowStruct() != FHitFX::StaticStruct())
+	{
+		return OutRows;
+	}
+
+	const FHitFX* DefaultRow = nullptr;
+
+	// First row per surface wins, same as the previous linear scan
+	for (const TPair<FName, uint8*>& Pair : Table->GetRowMap())
+	{
+		const FHitFX* Row = reinterpret_cast<const FHitFX*>(Pair.Value);
+		const EPhysicalSurface Surface = Row->SurfaceType;
+
+		if (!OutRows.Rows[Surface])
+		{
+			OutRows.Rows[Surface] = Row;
+		}
+		if (Surface == SurfaceType_Default && !DefaultRow)
+		{
+			DefaultRow = Row;
+		}
+	}
+
+	for (const FHitFX*& Row : OutRows.Rows)
+	{
+		if (!Row)
+		{
+			Row = DefaultRow;
+		}
+	}
+
+	return OutRows;
+}
@@ -0,0 +1,47 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/ChaosEngineInterface.h"
+
+struct FHitFX;
+class UDataTable;
+
+/**
+ * FHitFX rows of footstep data tables, indexed by surface type. Built once per table, with the SurfaceType_Default row
+ * already filled into every surface that has no row of its own. Rebuilt when the table changes (reimport/edit).
+ * Lookups of built tables take a shared lock only, so they are safe from any thread. Building binds the table's change
+ * delegate and only happens on the game thread, a miss elsewhere returns nullptr until the table is primed.
+ * Entries of garbage collected tables are dropped after each collection.
+ */
+class ANONLOCOMOTION_API FFootstepSurfaceCache final
+{
+public:
+	/**
+	 * @return Row used for this surface, nullptr if the table has neither a matching nor a default row, or is not built
+	 * yet and this is not the game thread
+	 */
+	static const FHitFX* Find(const UDataTable* Table, EPhysicalSurface Surface);
+
+	/** Build the lookup ahead of the first footstep. Game thread only */
+	static void Prime(const UDataTable* Table);
+
+	static void Invalidate(const UDataTable* Table);
+
+private:
+	struct FSurfaceRows
+	{
+		const FHitFX* Rows[SurfaceType_Max] = {};
+		FDelegateHandle ChangedHandle;
+	};
+
+	/** Must be called on the game thread with the write lock held */
+	static FSurfaceRows& Build(const UDataTable* Table);
+
+	static void RemoveCollectedTables();
+
+	static FRWLock Lock;
+	static TMap<TObjectKey<UDataTable>, FSurfaceRows> Tables;
+	static FDelegateHandle PostGarbageCollectHandle;
+};
@@ -0,0 +1,91 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/LocomotionProfiling.h"
+
+DEFINE_STAT(STAT_AnonLocomotion_CharacterTick);
+DEFINE_STAT(STAT_AnonLocomotion_SetEssentialValues);
+DEFINE_STAT(STAT_AnonLocomotion_UpdateGroundedRotation);
+DEFINE_STAT(STAT_AnonLocomotion_RagdollUpdate);
+DEFINE_STAT(STAT_AnonLocomotion_AnimUpdate);
+DEFINE_STAT(STAT_AnonLocomotion_UpdateFootIK);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepNotify);
+DEFINE_STAT(STAT_AnonLocomotion_WallScan);
+DEFINE_STAT(STAT_AnonLocomotion_CameraBehavior);
+DEFINE_STAT(STAT_AnonLocomotion_CrowdSimulate);
+DEFINE_STAT(STAT_AnonLocomotion_CrowdAgents);
+DEFINE_STAT(STAT_AnonLocomotion_CrowdHydrations);
+DEFINE_STAT(STAT_AnonLocomotion_CrowdFloorTraces);
+DEFINE_STAT(STAT_AnonLocomotion_CharacterSpawn);
+DEFINE_STAT(STAT_AnonLocomotion_CharacterAcquire);
+DEFINE_STAT(STAT_AnonLocomotion_CharactersReused);
+DEFINE_STAT(STAT_AnonLocomotion_TracesIssued);
+DEFINE_STAT(STAT_AnonLocomotion_MontagesPlayed);
+DEFINE_STAT(STAT_AnonLocomotion_DynamicMontagesCreated);
+DEFINE_STAT(STAT_AnonLocomotion_CurvesRead);
+DEFINE_STAT(STAT_AnonLocomotion_MovementSettingsMismatch);
+DEFINE_STAT(STAT_AnonLocomotion_RejectedClientGait);
+DEFINE_STAT(STAT_AnonLocomotion_TransformUpdates);
+DEFINE_STAT(STAT_AnonLocomotion_RotationSkipped);
+DEFINE_STAT(STAT_AnonLocomotion_CameraShakesStarted);
+DEFINE_STAT(STAT_AnonLocomotion_CameraShakesOverBudget);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepsQueued);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepSounds);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepNiagara);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepDecals);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepCulled);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepOverBudget);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepCoalesced);
+DEFINE_STAT(STAT_AnonLocomotion_FootstepTraceReused);
+
+#if LOCOMOTION_PROFILING_ENABLED
+UE_TRACE_CHANNEL_DEFINE(AnonLocomotionChannel);
+#endif
+
+std::atomic<bool> FLocomotionBenchmarkTimers::bEnabled(false);
+std::atomic<uint64> FLocomotionBenchmarkTimers::Cycles[static_cast<int32>(ELocomotionProfileStage::Num)];
+std::atomic<uint64> FLocomotionBenchmarkTimers::Calls[static_cast<int32>(ELocomotionProfileStage::Num)];
+
+void FLocomotionBenchmarkTimers::SetEnabled(bool bNewEnabled)
+{
+	bEnabled.store(bNewEnabled, std::memory_order_relaxed);
+}
+
+void FLocomotionBenchmarkTimers::Reset()
+{
+	for (int32 i = 0; i < static_cast<int32>(ELocomotionProfileStage::Num); ++i)
+	{
+		Cycles[i].store(0, std::memory_order_relaxed);
+		Calls[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void FLocomotionBenchmarkTimers::Add(ELocomotionProfileStage Stage, uint64 InCycles)
+{
+	Cycles[static_cast<int32>(Stage)].fetch_add(InCycles, std::memory_order_relaxed);
+	Calls[static_cast<int32>(Stage)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64 FLocomotionBenchmarkTimers::GetCycles(ELocomotionProfileStage Stage)
+{
+	return Cycles[static_cast<int32>(Stage)].load(std::memory_order_relaxed);
+}
+
+uint64 FLocomotionBenchmarkTimers::GetCalls(ELocomotionProfileStage Stage)
+{
+	return Calls[static_cast<int32>(Stage)].load(std::memory_order_relaxed);
+}
+
+const TCHAR* FLocomotionBenchmarkTimers::GetStageName(ELocomotionProfileStage Stage)
+{
+	// Keys of the benchmark JSON, keep them stable
+	switch (Stage)
+	{
+	case ELocomotionProfileStage::CharacterTick:		return TEXT("CharacterTick");
+	case ELocomotionProfileStage::CharacterMovement:	return TEXT("CharacterMovement");
+	case ELocomotionProfileStage::AnimUpdate:			return TEXT("AnimUpdate");
+	case ELocomotionProfileStage::Traversal:			return TEXT("Traversal");
+	case ELocomotionProfileStage::Camera:				return TEXT("Camera");
+	case ELocomotionProfileStage::Crowd:				return TEXT("Crowd");
+	default:											return TEXT("Unknown");
+	}
+}
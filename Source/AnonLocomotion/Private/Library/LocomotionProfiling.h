@@ -0,0 +1,145 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include <atomic>
+
+#define LOCOMOTION_PROFILING_ENABLED !UE_BUILD_SHIPPING
+
+// ==================== Stats ==================== //
+
+DECLARE_STATS_GROUP(TEXT("AnonLocomotion"), STATGROUP_AnonLocomotion, STATCAT_Advanced);
+
+//-- Character --//
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_AnonLocomotion_CharacterTick, STATGROUP_AnonLocomotion, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Set Essential Values"), STAT_AnonLocomotion_SetEssentialValues, STATGROUP_AnonLocomotion, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Grounded Rotation"), STAT_AnonLocomotion_UpdateGroundedRotation, STATGROUP_AnonLocomotion, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ragdoll Update"), STAT_AnonLocomotion_RagdollUpdate, STATGROUP_AnonLocomotion, );
+
+//-- Animation --//
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Thread Update"), STAT_AnonLocomotion_AnimUpdate, STATGROUP_AnonLocomotion, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Foot IK"), STAT_AnonLocomotion_UpdateFootIK, STATGROUP_AnonLocomotion, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Footstep Notify"), STAT_AnonLocomotion_FootstepNotify, STATGROUP_AnonLocomotion, );
+
+//-- Traversal --//
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Traversal Wall Scan"), STAT_AnonLocomotion_WallScan, STATGROUP_AnonLocomotion, );
+
+//-- Camera --//
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Camera Behavior"), STAT_AnonLocomotion_CameraBehavior, STATGROUP_AnonLocomotion, );
+
+//-- Crowd --//
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Crowd Simulate"), STAT_AnonLocomotion_CrowdSimulate, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crowd Agents Simulated"), STAT_AnonLocomotion_CrowdAgents, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crowd Hydrations"), STAT_AnonLocomotion_CrowdHydrations, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crowd Floor Traces"), STAT_AnonLocomotion_CrowdFloorTraces, STATGROUP_AnonLocomotion, );
+
+//-- Pooling --//
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Spawn"), STAT_AnonLocomotion_CharacterSpawn, STATGROUP_AnonLocomotion, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Acquire"), STAT_AnonLocomotion_CharacterAcquire, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Characters Reused"), STAT_AnonLocomotion_CharactersReused, STATGROUP_AnonLocomotion, );
+
+//-- Counters --//
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Issued"), STAT_AnonLocomotion_TracesIssued, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Montages Played"), STAT_AnonLocomotion_MontagesPlayed, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Dynamic Montages Created"), STAT_AnonLocomotion_DynamicMontagesCreated, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Curves Read"), STAT_AnonLocomotion_CurvesRead, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Movement Settings Mismatches"), STAT_AnonLocomotion_MovementSettingsMismatch, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Client Gaits Rejected"), STAT_AnonLocomotion_RejectedClientGait, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Actor Transform Updates"), STAT_AnonLocomotion_TransformUpdates, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rotation Updates Skipped"), STAT_AnonLocomotion_RotationSkipped, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Camera Shakes Started"), STAT_AnonLocomotion_CameraShakesStarted, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Camera Shakes Over Budget"), STAT_AnonLocomotion_CameraShakesOverBudget, STATGROUP_AnonLocomotion, );
+
+//-- Footstep FX --//
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footsteps Queued"), STAT_AnonLocomotion_FootstepsQueued, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Sounds Spawned"), STAT_AnonLocomotion_FootstepSounds, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Niagara Spawned"), STAT_AnonLocomotion_FootstepNiagara, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Decals Spawned"), STAT_AnonLocomotion_FootstepDecals, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep FX Culled"), STAT_AnonLocomotion_FootstepCulled, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep FX Over Budget"), STAT_AnonLocomotion_FootstepOverBudget, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Sounds Coalesced"), STAT_AnonLocomotion_FootstepCoalesced, STATGROUP_AnonLocomotion, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Foot IK Hits Reused"), STAT_AnonLocomotion_FootstepTraceReused, STATGROUP_AnonLocomotion, );
+
+// ==================== Insights ==================== //
+
+#if LOCOMOTION_PROFILING_ENABLED
+	/** Enable with -trace=cpu,AnonLocomotion (or Trace.Enable AnonLocomotion) to see the scopes below in Insights */
+	UE_TRACE_CHANNEL_EXTERN(AnonLocomotionChannel);
+
+	/** Stat cycle counter + Insights scope on the AnonLocomotion channel */
+	#define LOCOMOTION_SCOPE_CYCLE_COUNTER(Stat) \
+		SCOPE_CYCLE_COUNTER(Stat); \
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, AnonLocomotionChannel)
+
+	#define LOCOMOTION_INC_COUNTER(Stat, Amount) INC_DWORD_STAT_BY(Stat, Amount)
+#else
+	#define LOCOMOTION_SCOPE_CYCLE_COUNTER(Stat)
+	#define LOCOMOTION_INC_COUNTER(Stat, Amount)
+#endif
+
+// ==================== Benchmark ==================== //
+
+/** Per stage timings collected while a headless replay benchmark runs */
+enum class ELocomotionProfileStage : uint8
+{
+	CharacterTick,
+	CharacterMovement,
+	AnimUpdate,
+	Traversal,
+	Camera,
+	Crowd,
+	Num
+};
+
+/**
+ * Lock-free accumulators, the anim update stage runs on worker threads. Disabled (one relaxed load per scope) unless
+ * a benchmark turned them on.
+ */
+struct FLocomotionBenchmarkTimers
+{
+	static void SetEnabled(bool bNewEnabled);
+	static void Reset();
+
+	FORCEINLINE static bool IsEnabled() { return bEnabled.load(std::memory_order_relaxed); }
+
+	static void Add(ELocomotionProfileStage Stage, uint64 Cycles);
+
+	static uint64 GetCycles(ELocomotionProfileStage Stage);
+	static uint64 GetCalls(ELocomotionProfileStage Stage);
+	static const TCHAR* GetStageName(ELocomotionProfileStage Stage);
+
+private:
+	static std::atomic<bool> bEnabled;
+	static std::atomic<uint64> Cycles[static_cast<int32>(ELocomotionProfileStage::Num)];
+	static std::atomic<uint64> Calls[static_cast<int32>(ELocomotionProfileStage::Num)];
+};
+
+class FLocomotionBenchmarkScope
+{
+public:
+	explicit FLocomotionBenchmarkScope(ELocomotionProfileStage InStage)
+		: Stage(InStage), StartCycles(FLocomotionBenchmarkTimers::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FLocomotionBenchmarkScope()
+	{
+		if (StartCycles != 0)
+		{
+			FLocomotionBenchmarkTimers::Add(Stage, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	ELocomotionProfileStage Stage;
+	uint64 StartCycles;
+};
+
+#if LOCOMOTION_PROFILING_ENABLED
+	#define LOCOMOTION_BENCHMARK_SCOPE(Stage) FLocomotionBenchmarkScope PREPROCESSOR_JOIN(LocomotionBenchmarkScope_, __LINE__)(ELocomotionProfileStage::Stage)
+#else
+	#define LOCOMOTION_BENCHMARK_SCOPE(Stage)
+#endif
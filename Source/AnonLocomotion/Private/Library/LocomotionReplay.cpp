@@ -0,0 +1,159 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/LocomotionReplay.h"
+
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace LocomotionReplay
+{
+	constexpr uint8 PressedBit = 0x80;
+	constexpr uint8 ActionMask = 0x7F;
+
+	/** Delta time, pitch, yaw and event count */
+	constexpr int64 MinFrameBytes = sizeof(float) + 2 * sizeof(uint16) + sizeof(uint8);
+	constexpr int64 MinEventBytes = sizeof(uint8);
+
+	/** A count read from the stream can't claim more entries than the bytes left could hold */
+	bool FitsInArchive(FArchive& Ar, int64 Count, int64 MinBytesPerEntry)
+	{
+		const int64 TotalSize = Ar.TotalSize();
+		return TotalSize < 0 || Count * MinBytesPerEntry <= TotalSize - Ar.Tell();
+	}
+
+	int16 QuantizeAxis(double Value)
+	{
+		return static_cast<int16>(FMath::RoundToInt(FMath::Clamp(Value, -1.0, 1.0) * MAX_int16));
+	}
+
+	double DequantizeAxis(int16 Value)
+	{
+		return static_cast<double>(Value) / MAX_int16;
+	}
+}
+
+void FLocomotionInputRecording::Serialize(FArchive& Ar)
+{
+	uint32 FileMagic = Magic;
+	uint16 FileVersion = Version;
+	Ar << FileMagic << FileVersion;
+
+	if (Ar.IsLoading() && (FileMagic != Magic || FileVersion != Version))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	int32 NumFrames = Frames.Num();
+	Ar << NumFrames;
+	if (Ar.IsLoading())
+	{
+		if (NumFrames < 0 || !LocomotionReplay::FitsInArchive(Ar, NumFrames, LocomotionReplay::MinFrameBytes))
+		{
+			Ar.SetError();
+			return;
+		}
+		Frames.SetNum(NumFrames);
+	}
+
+	for (FLocomotionInputFrame& Frame : Frames)
+	{
+		uint16 Pitch = FRotator::CompressAxisToShort(Frame.ControlRotation.Pitch);
+		uint16 Yaw = FRotator::CompressAxisToShort(Frame.ControlRotation.Yaw);
+		uint8 NumEvents = static_cast<uint8>(FMath::Min(Frame.Events.Num(), static_cast<int32>(MAX_uint8)));
+		Ar << Frame.DeltaTime << Pitch << Yaw << NumEvents;
+
+		if (Ar.IsLoading())
+		{
+			if (Ar.IsError() || !LocomotionReplay::FitsInArchive(Ar, NumEvents, LocomotionReplay::MinEventBytes))
+			{
+				Ar.SetError();
+				return;
+			}
+
+			Frame.ControlRotation = FRotator(FRotator::DecompressAxisFromShort(Pitch),
+			                                 FRotator::DecompressAxisFromShort(Yaw), 0.0f);
+			Frame.Events.SetNum(NumEvents);
+		}
+
+		for (int32 i = 0; i < NumEvents; ++i)
+		{
+			FLocomotionInputEvent& Event = Frame.Events[i];
+
+			uint8 Packed = static_cast<uint8>(Event.Action) | (Event.Value.X != 0.0 ? LocomotionReplay::PressedBit : 0);
+			Ar << Packed;
+			Event.Action = static_cast<ELocomotionInputAction>(Packed & LocomotionReplay::ActionMask);
+
+			if (Event.Action == ELocomotionInputAction::Move)
+			{
+				int16 X = LocomotionReplay::QuantizeAxis(Event.Value.X);
+				int16 Y = LocomotionReplay::QuantizeAxis(Event.Value.Y);
+				Ar << X << Y;
+				Event.Value = FVector2D(LocomotionReplay::DequantizeAxis(X), LocomotionReplay::DequantizeAxis(Y));
+			}
+			else
+			{
+				Event.Value = FVector2D((Packed & LocomotionReplay::PressedBit) ? 1.0 : 0.0, 0.0);
+			}
+
+			if (Event.Action >= ELocomotionInputAction::Num)
+			{
+				Ar.SetError();
+				return;
+			}
+		}
+	}
+}
+
+bool FLocomotionInputRecording::SaveToFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Serialize(Writer);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FLocomotionInputRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Serialize(Reader);
+
+	if (Reader.IsError())
+	{
+		Frames.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FLocomotionInputRecorder::Start()
+{
+	bRecording = true;
+	PendingEvents.Reset();
+	Recording.Frames.Reset();
+}
+
+void FLocomotionInputRecorder::Stop()
+{
+	bRecording = false;
+	PendingEvents.Reset();
+}
+
+void FLocomotionInputRecorder::EndFrame(float DeltaTime, const FRotator& ControlRotation)
+{
+	if (!bRecording) return;
+
+	FLocomotionInputFrame& Frame = Recording.Frames.AddDefaulted_GetRef();
+	Frame.DeltaTime = DeltaTime;
+	Frame.ControlRotation = ControlRotation;
+	Frame.Events = MoveTemp(PendingEvents);
+	PendingEvents.Reset();
+}
@@ -0,0 +1,85 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Character input actions a replay can capture. Values are serialized, append only */
+enum class ELocomotionInputAction : uint8
+{
+	Move,
+	Jump,
+	Sprint,
+	Aim,
+	CameraTap,
+	CameraHeld,
+	Stance,
+	Walk,
+	Ragdoll,
+	VelocityDirection,
+	LookingDirection,
+	ChangeOverlay,
+	Num
+};
+
+struct FLocomotionInputEvent
+{
+	ELocomotionInputAction Action = ELocomotionInputAction::Move;
+
+	/** Move axis, or X != 0 for pressed/released actions */
+	FVector2D Value = FVector2D::ZeroVector;
+};
+
+/**
+ * Everything the character received during one frame. Looking is captured as the resulting control rotation rather
+ * than raw look deltas, so a replay does not depend on a player controller or on look rates.
+ */
+struct FLocomotionInputFrame
+{
+	float DeltaTime = 0.0f;
+	FRotator ControlRotation = FRotator::ZeroRotator;
+	TArray<FLocomotionInputEvent, TInlineAllocator<4>> Events;
+};
+
+/**
+ * Compact binary stream of input frames. Per frame: delta time, 2 x 16 bit control rotation, event count, then one
+ * byte per event (action + pressed bit), with 2 x 16 bit axis values for Move only.
+ */
+struct FLocomotionInputRecording
+{
+	static constexpr uint32 Magic = 0x504C4E41; // "ANLP"
+	static constexpr uint16 Version = 1;
+
+	TArray<FLocomotionInputFrame> Frames;
+
+	void Serialize(FArchive& Ar);
+
+	bool SaveToFile(const FString& Filename);
+	bool LoadFromFile(const FString& Filename);
+};
+
+/** Collects input events until the character ticks, then closes them into a frame */
+class FLocomotionInputRecorder
+{
+public:
+	void Start();
+	void Stop();
+	FORCEINLINE bool IsRecording() const { return bRecording; }
+
+	FORCEINLINE void Record(ELocomotionInputAction Action, const FVector2D& Value = FVector2D::ZeroVector)
+	{
+		if (bRecording)
+		{
+			PendingEvents.Add({Action, Value});
+		}
+	}
+
+	void EndFrame(float DeltaTime, const FRotator& ControlRotation);
+
+	FORCEINLINE FLocomotionInputRecording& GetRecording() { return Recording; }
+
+private:
+	bool bRecording = false;
+	TArray<FLocomotionInputEvent, TInlineAllocator<4>> PendingEvents;
+	FLocomotionInputRecording Recording;
+};
@@ -0,0 +1,147 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/LocomotionRules.h"
+
+#include "Curves/CurveFloat.h"
+#include "Data/LocomotionStruct.h"
+
+const FMovementSettings& FLocomotionRules::SelectMovementSettings(const FMovementStateSettings& MovementData,
+                                                                  ERotationMode RotationMode, EStance Stance)
+{
+	const FMovementStanceSettings* StanceSettings = &MovementData.VelocityDirection;
+	if (RotationMode == ERotationMode::LookingDirection)
+	{
+		StanceSettings = &MovementData.LookingDirection;
+	}
+	else if (RotationMode == ERotationMode::Aiming)
+	{
+		StanceSettings = &MovementData.Aiming;
+	}
+
+	if (Stance == EStance::Standing)
+	{
+		return StanceSettings->Standing;
+	}
+	if (Stance == EStance::Crouching)
+	{
+		return StanceSettings->Crouching;
+	}
+
+	// Default to velocity dir standing
+	return MovementData.VelocityDirection.Standing;
+}
+
+float FLocomotionRules::GetMappedSpeed(float Speed, const FMovementSettings& Settings)
+{
+	// Map the speed to the configured movement speeds with a range of 0-3. This allows us to vary the movement speeds
+	// but still use the mapped range in calculations for consistent results
+
+	if (Speed > Settings.RunSpeed)
+	{
+		return FMath::GetMappedRangeValueClamped<float, float>({Settings.RunSpeed, Settings.SprintSpeed}, {2.0f, 3.0f}, Speed);
+	}
+
+	if (Speed > Settings.WalkSpeed)
+	{
+		return FMath::GetMappedRangeValueClamped<float, float>({Settings.WalkSpeed, Settings.RunSpeed}, {1.0f, 2.0f}, Speed);
+	}
+
+	return FMath::GetMappedRangeValueClamped<float, float>({0.0f, Settings.WalkSpeed}, {0.0f, 1.0f}, Speed);
+}
+
+bool FLocomotionRules::CanSprint(ERotationMode RotationMode, bool bHasMovementInput, float MovementInputAmount,
+                                 const FRotator& MovementInputRotation, const FRotator& AimingRotation)
+{
+	// Determine if the character is currently able to sprint based on the Rotation mode and current acceleration
+	// (input) rotation. If the character is in the Looking Rotation mode, only allow sprinting if there is full
+	// movement input, and it is faced forward relative to the camera + or - 50 degrees.
+
+	if (!bHasMovementInput || RotationMode == ERotationMode::Aiming)
+	{
+		return false;
+	}
+
+	const bool bValidInputAmount = MovementInputAmount > 0.9f;
+
+	if (RotationMode == ERotationMode::VelocityDirection)
+	{
+		return bValidInputAmount;
+	}
+
+	if (RotationMode == ERotationMode::LookingDirection)
+	{
+		FRotator Delta = MovementInputRotation - AimingRotation;
+		Delta.Normalize();
+
+		return bValidInputAmount && FMath::Abs(Delta.Yaw) < 50.0f;
+	}
+
+	return false;
+}
+
+EGait FLocomotionRules::GetAllowedGait(EStance Stance, ERotationMode RotationMode, EGait DesiredGait, bool bCanSprint)
+{
+	// Calculate the Allowed Gait. This represents the maximum Gait the character is currently allowed to be in,
+	// and can be determined by the desired gait, the rotation mode, the stance, etc. For example,
+	// if you wanted to force the character into a walking state while indoors, this could be done here.
+
+	if (Stance == EStance::Standing && RotationMode != ERotationMode::Aiming)
+	{
+		if (DesiredGait == EGait::Sprinting)
+		{
+			return bCanSprint ? EGait::Sprinting : EGait::Running;
+		}
+		return DesiredGait;
+	}
+
+	// Crouching stance & Aiming rot mode has same behaviour
+
+	if (DesiredGait == EGait::Sprinting)
+	{
+		return EGait::Running;
+	}
+
+	return DesiredGait;
+}
+
+EGait FLocomotionRules::GetActualGait(float Speed, const FMovementSettings& Settings, EGait AllowedGait)
+{
+	// Get the Actual Gait. This is calculated by the actual movement of the character,  and so it can be different
+	// from the desired gait or allowed gait. For instance, if the Allowed Gait becomes walking,
+	// the Actual gait will still be running until the character decelerates to the walking speed.
+
+	if (Speed > Settings.RunSpeed + 10.0f)
+	{
+		if (AllowedGait == EGait::Sprinting)
+		{
+			return EGait::Sprinting;
+		}
+		return EGait::Running;
+	}
+
+	if (Speed >= Settings.WalkSpeed + 10.0f)
+	{
+		return EGait::Running;
+	}
+
+	return EGait::Walking;
+}
+
+float FLocomotionRules::GetGroundedRotationRate(const FMovementSettings& Settings, float MappedSpeed, float AimYawRate)
+{
+	// Calculate the rotation rate by using the current Rotation Rate Curve in the Movement Settings.
+	// Using the curve in conjunction with the mapped speed gives you a high level of control over the rotation
+	// rates for each speed. Increase the speed if the camera is rotating quickly for more responsive rotation.
+
+	const float CurveVal = Settings.RotationRateCurve ? Settings.RotationRateCurve->GetFloatValue(MappedSpeed) : 1.0f;
+	const float ClampedAimYawRate = FMath::GetMappedRangeValueClamped<float, float>({0.0f, 300.0f}, {1.0f, 3.0f}, AimYawRate);
+	return CurveVal * ClampedAimYawRate;
+}
+
+FRotator FLocomotionRules::SmoothRotation(const FRotator& Current, FRotator& InOutTargetRotation, const FRotator& Target,
+                                          float TargetInterpSpeed, float ActorInterpSpeed, float DeltaTime)
+{
+	// Interpolate the Target Rotation for extra smooth rotation behavior
+	InOutTargetRotation = FMath::RInterpConstantTo(InOutTargetRotation, Target, DeltaTime, TargetInterpSpeed);
+	return FMath::RInterpTo(Current, InOutTargetRotation, DeltaTime, ActorInterpSpeed);
+}
@@ -0,0 +1,36 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionEnum.h"
+
+struct FMovementSettings;
+struct FMovementStateSettings;
+
+/**
+ * Gait and rotation rules of the locomotion, free of any actor state. Shared by AAnonCharacter and the crowd agents of
+ * UAnonCrowdSubsystem so a character picks the same gait and turns the same way in both representations.
+ */
+class ANONLOCOMOTION_API FLocomotionRules final
+{
+public:
+	static const FMovementSettings& SelectMovementSettings(const FMovementStateSettings& MovementData,
+	                                                       ERotationMode RotationMode, EStance Stance);
+
+	/** Speed mapped to 0-3, 0 = stopped, 1 = the Walk Speed, 2 = the Run Speed and 3 = the Sprint Speed */
+	static float GetMappedSpeed(float Speed, const FMovementSettings& Settings);
+
+	static bool CanSprint(ERotationMode RotationMode, bool bHasMovementInput, float MovementInputAmount,
+	                      const FRotator& MovementInputRotation, const FRotator& AimingRotation);
+
+	/** @param bCanSprint Only read when sprinting is desired */
+	static EGait GetAllowedGait(EStance Stance, ERotationMode RotationMode, EGait DesiredGait, bool bCanSprint);
+	static EGait GetActualGait(float Speed, const FMovementSettings& Settings, EGait AllowedGait);
+
+	static float GetGroundedRotationRate(const FMovementSettings& Settings, float MappedSpeed, float AimYawRate);
+
+	/** Interpolates InOutTargetRotation towards Target, then returns Current interpolated towards it */
+	static FRotator SmoothRotation(const FRotator& Current, FRotator& InOutTargetRotation, const FRotator& Target,
+	                               float TargetInterpSpeed, float ActorInterpSpeed, float DeltaTime);
+};
@@ -0,0 +1,103 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/MontageCurveTracker.h"
+
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "UObject/ObjectKey.h"
+
+FRWLock FMontageCurveTracker::Lock;
+TMap<FMontageCurveTracker::FCurveKey, TSharedPtr<const FBakedAnimCurve>> FMontageCurveTracker::BakedCurves;
+
+float FMontageCurveTracker::GetCurveValue(const UAnimInstance& AnimInstance, FName CurveName)
+{
+	const FAnimMontageInstance* MontageInstance = AnimInstance.GetActiveMontageInstance();
+	if (!MontageInstance || !MontageInstance->Montage) return 0.0f;
+
+	const UAnimMontage* Montage = MontageInstance->Montage;
+	const float Position = MontageInstance->GetPosition();
+
+	const FAnimSegment* Segment = nullptr;
+	if (TrackedMontage.Get() == Montage && Montage->SlotAnimTracks.IsValidIndex(TrackedSlot))
+	{
+		const TArray<FAnimSegment>& Segments = Montage->SlotAnimTracks[TrackedSlot].AnimTrack.AnimSegments;
+		if (Segments.IsValidIndex(TrackedSegment) && Segments[TrackedSegment].IsInRange(Position))
+		{
+			Segment = &Segments[TrackedSegment];
+		}
+	}
+
+	if (!Segment)
+	{
+		TrackedMontage = Montage;
+		TrackedSlot = INDEX_NONE;
+		TrackedSegment = INDEX_NONE;
+
+		for (int32 SlotIndex = 0; SlotIndex < Montage->SlotAnimTracks.Num() && !Segment; ++SlotIndex)
+		{
+			const TArray<FAnimSegment>& Segments = Montage->SlotAnimTracks[SlotIndex].AnimTrack.AnimSegments;
+			for (int32 SegmentIndex = 0; SegmentIndex < Segments.Num(); ++SegmentIndex)
+			{
+				if (Segments[SegmentIndex].IsInRange(Position))
+				{
+					Segment = &Segments[SegmentIndex];
+					TrackedSlot = SlotIndex;
+					TrackedSegment = SegmentIndex;
+					break;
+				}
+			}
+		}
+	}
+
+	if (!Segment) return 0.0f;
+
+	const TSharedPtr<const FBakedAnimCurve> Baked = FindBakedCurve(Segment->GetAnimReference(), CurveName);
+	if (!Baked.IsValid()) return 0.0f;
+
+	return Baked->Sample(Segment->ConvertTrackPosToAnimPos(Position)) * MontageInstance->GetWeight();
+}
+
+void FMontageCurveTracker::Reset()
+{
+	TrackedMontage.Reset();
+	TrackedSlot = INDEX_NONE;
+	TrackedSegment = INDEX_NONE;
+}
+
+TSharedPtr<const FBakedAnimCurve> FMontageCurveTracker::FindBakedCurve(const UAnimSequenceBase* Animation,
+                                                                       FName CurveName)
+{
+	if (!Animation) return nullptr;
+
+	const FCurveKey Key(Animation, CurveName);
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const TSharedPtr<const FBakedAnimCurve>* Found = BakedCurves.Find(Key))
+		{
+			return *Found;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have baked it while we waited for the write lock
+	if (const TSharedPtr<const FBakedAnimCurve>* Found = BakedCurves.Find(Key))
+	{
+		return *Found;
+	}
+
+	// Animations without the curve are remembered too, so they are only checked once
+	TSharedPtr<FBakedAnimCurve> Baked;
+	if (Animation->HasCurveData(CurveName))
+	{
+		Baked = MakeShared<FBakedAnimCurve>();
+		const int32 NumSamples = FMath::CeilToInt(Animation->GetPlayLength() * FBakedAnimCurve::SampleRate) + 1;
+		Baked->Samples.SetNumUninitialized(NumSamples);
+		for (int32 i = 0; i < NumSamples; ++i)
+		{
+			Baked->Samples[i] = Animation->EvaluateCurveData(CurveName, i / FBakedAnimCurve::SampleRate);
+		}
+	}
+
+	return BakedCurves.Add(Key, Baked);
+}
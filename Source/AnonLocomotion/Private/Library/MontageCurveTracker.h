@@ -0,0 +1,53 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UAnimInstance;
+class UAnimMontage;
+class UAnimSequenceBase;
+
+/** One float curve of an animation sampled at 30 Hz, the rate the ALS rotation curves are authored for */
+struct FBakedAnimCurve
+{
+	static constexpr float SampleRate = 30.0f;
+
+	TArray<float> Samples;
+
+	float Sample(float Time) const
+	{
+		const float Index = FMath::Clamp(Time * SampleRate, 0.0f, static_cast<float>(Samples.Num() - 1));
+		const int32 Lower = FMath::FloorToInt(Index);
+		const int32 Upper = FMath::Min(Lower + 1, Samples.Num() - 1);
+		return FMath::Lerp(Samples[Lower], Samples[Upper], Index - Lower);
+	}
+};
+
+/**
+ * Reads animation curves of the playing montage without evaluating the anim graph, for dedicated servers that only tick
+ * montages. Curves are baked once per animation and curve name, shared by every character, and sampled at the montage
+ * position. Lookups take a shared lock only, so they are safe from any thread.
+ */
+class ANONLOCOMOTION_API FMontageCurveTracker final
+{
+public:
+	/** Curve value of the active montage, weighted by its blend like the slot node would. 0 without a montage */
+	float GetCurveValue(const UAnimInstance& AnimInstance, FName CurveName);
+
+	void Reset();
+
+	/** @return nullptr if the animation has no such curve */
+	static TSharedPtr<const FBakedAnimCurve> FindBakedCurve(const UAnimSequenceBase* Animation, FName CurveName);
+
+private:
+	/** Segment of the last lookup, montage positions rarely leave it between two reads */
+	TWeakObjectPtr<const UAnimMontage> TrackedMontage;
+	int32 TrackedSlot = INDEX_NONE;
+	int32 TrackedSegment = INDEX_NONE;
+
+	using FCurveKey = TPair<TObjectKey<UAnimSequenceBase>, FName>;
+
+	static FRWLock Lock;
+	static TMap<FCurveKey, TSharedPtr<const FBakedAnimCurve>> BakedCurves;
+};
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Library/MovementCurveCache.h"
+
+#include "Curves/CurveVector.h"
+#include "UObject/ObjectKey.h"
+
+FRWLock FMovementCurveCache::Lock;
+TMap<TObjectKey<UCurveVector>, FMovementCurveCache::FBakedEntry> FMovementCurveCache::Curves;
+
+TSharedPtr<const FBakedMovementCurve> FMovementCurveCache::Find(const UCurveVector* Curve)
+{
+	if (!Curve) return nullptr;
+
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const FBakedEntry* Found = Curves.Find(Curve))
+		{
+			return Found->Baked;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have built it while we waited for the write lock
+	if (const FBakedEntry* Found = Curves.Find(Curve))
+	{
+		return Found->Baked;
+	}
+	return Build(Curve).Baked;
+}
+
+void FMovementCurveCache::Invalidate(const UCurveVector* Curve)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	FBakedEntry Removed;
+	if (Curves.RemoveAndCopyValue(Curve, Removed))
+	{
+#if WITH_EDITOR
+		const_cast<UCurveVector*>(Curve)->OnUpdateCurve.Remove(Removed.ChangedHandle);
+#endif
+	}
+}
+
+FMovementCurveCache::FBakedEntry& FMovementCurveCache::Build(const UCurveVector* Curve)
+{
+	FBakedEntry& OutEntry = Curves.Add(Curve);
+
+#if WITH_EDITOR
+	// Characters pick the new samples up with their next movement settings change
+	TWeakObjectPtr<const UCurveVector> WeakCurve = Curve;
+	OutEntry.ChangedHandle = const_cast<UCurveVector*>(Curve)->OnUpdateCurve.AddLambda(
+		[WeakCurve](UCurveBase*, EPropertyChangeType::Type)
+		{
+			Invalidate(WeakCurve.Get());
+		});
+#endif
+
+	TSharedRef<FBakedMovementCurve> Baked = MakeShared<FBakedMovementCurve>();
+	for (int32 i = 0; i < FBakedMovementCurve::NumSamples; ++i)
+	{
+		Baked->Samples[i] = Curve->GetVectorValue(static_cast<float>(i) / FBakedMovementCurve::SamplesPerUnit);
+	}
+	OutEntry.Baked = Baked;
+
+	return OutEntry;
+}
@@ -0,0 +1,53 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCurveVector;
+
+/**
+ * A movement curve (X acceleration, Y braking deceleration, Z ground friction) sampled at fixed steps of the 0-3 mapped
+ * speed. Client and server read the same sample for the same quantized speed, so small velocity differences between
+ * them don't turn into different acceleration and the move predicts without a correction.
+ */
+struct FBakedMovementCurve
+{
+	static constexpr int32 SamplesPerUnit = 32;
+	static constexpr int32 NumSamples = 3 * SamplesPerUnit + 1;
+
+	FVector Samples[NumSamples];
+
+	static int32 QuantizeMappedSpeed(float MappedSpeed)
+	{
+		return FMath::Clamp(FMath::RoundToInt(MappedSpeed * SamplesPerUnit), 0, NumSamples - 1);
+	}
+
+	const FVector& Sample(float MappedSpeed) const { return Samples[QuantizeMappedSpeed(MappedSpeed)]; }
+};
+
+/**
+ * Baked movement curves, built once per curve asset and shared by every character using it. Rebuilt when the curve is
+ * edited. Lookups take a shared lock only, so they are safe from any thread.
+ */
+class ANONLOCOMOTION_API FMovementCurveCache final
+{
+public:
+	/** @return nullptr for a null curve */
+	static TSharedPtr<const FBakedMovementCurve> Find(const UCurveVector* Curve);
+
+	static void Invalidate(const UCurveVector* Curve);
+
+private:
+	struct FBakedEntry
+	{
+		TSharedPtr<const FBakedMovementCurve> Baked;
+		FDelegateHandle ChangedHandle;
+	};
+
+	/** Must be called with the write lock held */
+	static FBakedEntry& Build(const UCurveVector* Curve);
+
+	static FRWLock Lock;
+	static TMap<TObjectKey<UCurveVector>, FBakedEntry> Curves;
+};
@@ -0,0 +1,161 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/AnonCharacterPoolSubsystem.h"
+
+#include "Characters/AnonCharacter.h"
+#include "Components/ActorComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Library/LocomotionProfiling.h"
+
+void UAnonCharacterPoolSubsystem::Deinitialize()
+{
+	// Actors go away with the world
+	Pooled.Empty();
+
+	Super::Deinitialize();
+}
+
+AAnonCharacter* UAnonCharacterPoolSubsystem::AcquireCharacter(TSubclassOf<AAnonCharacter> CharacterClass,
+                                                              const FTransform& Transform)
+{
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_CharacterAcquire);
+
+	if (!CharacterClass) return nullptr;
+
+	for (int32 i = Pooled.Num() - 1; i >= 0; --i)
+	{
+		AAnonCharacter* Character = Pooled[i];
+		if (!IsValid(Character))
+		{
+			Pooled.RemoveAtSwap(i);
+			continue;
+		}
+		if (Character->GetClass() != CharacterClass) continue;
+
+		Pooled.RemoveAtSwap(i);
+		Activate(Character, Transform);
+		Character->ResetLocomotionState();
+
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CharactersReused, 1);
+		return Character;
+	}
+
+	return SpawnCharacter(CharacterClass, Transform);
+}
+
+void UAnonCharacterPoolSubsystem::ReleaseCharacter(AAnonCharacter* Character)
+{
+	if (!IsValid(Character)) return;
+
+	AController* Controller = Character->GetController();
+	if (Controller && Controller->IsPlayerController())
+	{
+		Controller->UnPossess();
+		Controller = nullptr;
+	}
+
+	if (GetNumPooled(Character->GetClass()) >= MaxPooledPerClass)
+	{
+		if (Controller)
+		{
+			Controller->Destroy();
+		}
+		Character->Destroy();
+		return;
+	}
+
+	Deactivate(Character);
+	Pooled.Add(Character);
+}
+
+void UAnonCharacterPoolSubsystem::Prewarm(TSubclassOf<AAnonCharacter> CharacterClass, int32 Count,
+                                          const FTransform& Transform)
+{
+	if (!CharacterClass) return;
+
+	const int32 NumToSpawn = FMath::Min(Count, MaxPooledPerClass) - GetNumPooled(CharacterClass);
+	for (int32 i = 0; i < NumToSpawn; ++i)
+	{
+		if (AAnonCharacter* Character = SpawnCharacter(CharacterClass, Transform))
+		{
+			Deactivate(Character);
+			Pooled.Add(Character);
+		}
+	}
+}
+
+int32 UAnonCharacterPoolSubsystem::GetNumPooled(TSubclassOf<AAnonCharacter> CharacterClass) const
+{
+	int32 NumPooled = 0;
+	for (const AAnonCharacter* Character : Pooled)
+	{
+		if (IsValid(Character) && Character->GetClass() == CharacterClass)
+		{
+			++NumPooled;
+		}
+	}
+	return NumPooled;
+}
+
+AAnonCharacter* UAnonCharacterPoolSubsystem::SpawnCharacter(UClass* CharacterClass, const FTransform& Transform) const
+{
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_CharacterSpawn);
+
+	UWorld* World = GetWorld();
+	check(World);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	return World->SpawnActor<AAnonCharacter>(CharacterClass, Transform, SpawnParams);
+}
+
+void UAnonCharacterPoolSubsystem::Deactivate(AAnonCharacter* Character)
+{
+	Character->GetCharacterMovement()->StopMovementImmediately();
+
+	Character->SetActorTickEnabled(false);
+	for (UActorComponent* Component : Character->GetComponents())
+	{
+		Component->SetComponentTickEnabled(false);
+	}
+
+	Character->SetActorEnableCollision(false);
+	Character->SetActorHiddenInGame(true);
+
+	// Attached actors, e.g. the traversal debug arrow
+	TArray<AActor*> AttachedActors;
+	Character->GetAttachedActors(AttachedActors);
+	for (AActor* Attached : AttachedActors)
+	{
+		Attached->SetActorHiddenInGame(true);
+	}
+
+	// Goes dormant once the hidden state reached the clients
+	Character->SetNetDormancy(DORM_DormantAll);
+}
+
+void UAnonCharacterPoolSubsystem::Activate(AAnonCharacter* Character, const FTransform& Transform)
+{
+	Character->SetNetDormancy(DORM_Awake);
+
+	Character->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+
+	TArray<AActor*> AttachedActors;
+	Character->GetAttachedActors(AttachedActors);
+	for (AActor* Attached : AttachedActors)
+	{
+		Attached->SetActorHiddenInGame(false);
+	}
+
+	Character->SetActorHiddenInGame(false);
+	Character->SetActorEnableCollision(true);
+
+	for (UActorComponent* Component : Character->GetComponents())
+	{
+		Component->SetComponentTickEnabled(Component->PrimaryComponentTick.bStartWithTickEnabled);
+	}
+	Character->SetActorTickEnabled(Character->PrimaryActorTick.bStartWithTickEnabled);
+}
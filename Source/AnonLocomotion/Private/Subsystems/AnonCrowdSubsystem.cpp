@@ -0,0 +1,438 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/AnonCrowdSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Characters/AnonCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/DataTable.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Library/LocomotionProfiling.h"
+#include "Library/LocomotionRules.h"
+#include "Subsystems/AnonCharacterPoolSubsystem.h"
+
+static void SimulateCrowdAgent(FAnonCrowdAgent& Agent, const FMovementStateSettings& MovementData,
+                               float MaxAcceleration, float BrakingDeceleration, float DeltaTime)
+{
+	const FMovementSettings& Settings =
+		FLocomotionRules::SelectMovementSettings(MovementData, Agent.RotationMode, Agent.Stance);
+
+	const float MovementInputAmount = FMath::Min(static_cast<float>(Agent.MovementInput.Size2D()), 1.0f);
+	const bool bHasMovementInput = MovementInputAmount > 0.0f;
+
+	const bool bCanSprint = Agent.DesiredGait == EGait::Sprinting &&
+		FLocomotionRules::CanSprint(Agent.RotationMode, bHasMovementInput, MovementInputAmount,
+		                            Agent.MovementInput.ToOrientationRotator(), Agent.AimingRotation);
+	const EGait AllowedGait =
+		FLocomotionRules::GetAllowedGait(Agent.Stance, Agent.RotationMode, Agent.DesiredGait, bCanSprint);
+
+	// Constant acceleration towards the allowed gait speed
+	FVector DesiredVelocity = Agent.MovementInput.GetClampedToMaxSize2D(1.0f) * Settings.GetSpeedForGait(AllowedGait);
+	DesiredVelocity.Z = 0.0f;
+	const float MaxVelocityChange = (bHasMovementInput ? MaxAcceleration : BrakingDeceleration) * DeltaTime;
+	Agent.Velocity += (DesiredVelocity - Agent.Velocity).GetClampedToMaxSize(MaxVelocityChange);
+	Agent.Location += Agent.Velocity * DeltaTime;
+
+	Agent.Speed = Agent.Velocity.Size2D();
+	Agent.Gait = FLocomotionRules::GetActualGait(Agent.Speed, Settings, AllowedGait);
+
+	// Grounded rotation of the character, without the yaw offset and turn in place curves of the animations
+	if (!((bHasMovementInput && Agent.Speed > 1.0f) || Agent.Speed > 150.0f)) return;
+
+	const float RotationRate = FLocomotionRules::GetGroundedRotationRate(
+		Settings, FLocomotionRules::GetMappedSpeed(Agent.Speed, Settings), 0.0f);
+	const float VelocityYaw = Agent.Velocity.ToOrientationRotator().Yaw;
+
+	if (Agent.RotationMode == ERotationMode::VelocityDirection)
+	{
+		Agent.Rotation = FLocomotionRules::SmoothRotation(Agent.Rotation, Agent.TargetRotation, {0.0f, VelocityYaw, 0.0f},
+		                                                  800.0f, RotationRate, DeltaTime);
+	}
+	else if (Agent.RotationMode == ERotationMode::LookingDirection)
+	{
+		const float YawValue = Agent.Gait == EGait::Sprinting ? VelocityYaw : Agent.AimingRotation.Yaw;
+		Agent.Rotation = FLocomotionRules::SmoothRotation(Agent.Rotation, Agent.TargetRotation, {0.0f, YawValue, 0.0f},
+		                                                  500.0f, RotationRate, DeltaTime);
+	}
+	else if (Agent.RotationMode == ERotationMode::Aiming)
+	{
+		Agent.Rotation = FLocomotionRules::SmoothRotation(Agent.Rotation, Agent.TargetRotation,
+		                                                  {0.0f, Agent.AimingRotation.Yaw, 0.0f}, 1000.0f, 20.0f,
+		                                                  DeltaTime);
+	}
+}
+
+void UAnonCrowdSubsystem::Deinitialize()
+{
+	Agents.Empty();
+	AgentActors.Empty();
+	FreeIndices.Empty();
+	NumHydrated = 0;
+	ArchetypeClasses.Empty();
+	ArchetypeMovementData.Empty();
+	ArchetypeHalfHeights.Empty();
+	FloorSnapCursor = 0;
+
+	Super::Deinitialize();
+}
+
+void UAnonCrowdSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetNumAgents() == 0) return;
+
+	SyncHydratedAgents();
+	SimulateAgents(DeltaTime);
+	SnapAgentsToFloor();
+	UpdateHydration();
+}
+
+TStatId UAnonCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnonCrowdSubsystem, STATGROUP_Tickables);
+}
+
+// ==================== Agents ==================== //
+
+FAnonCrowdAgentHandle UAnonCrowdSubsystem::AddAgent(TSubclassOf<AAnonCharacter> CharacterClass,
+                                                    const FTransform& Transform)
+{
+	FAnonCrowdAgentHandle Handle;
+
+	const int32 ArchetypeIndex = FindOrAddArchetype(CharacterClass);
+	if (ArchetypeIndex == INDEX_NONE) return Handle;
+
+	if (FreeIndices.Num() > 0)
+	{
+		Handle.Index = FreeIndices.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		Handle.Index = Agents.AddDefaulted();
+		AgentActors.AddDefaulted();
+	}
+	Handle.Serial = NextSerial++;
+
+	FAnonCrowdAgent& Agent = Agents[Handle.Index];
+	Agent = FAnonCrowdAgent();
+	Agent.Location = Transform.GetLocation();
+	Agent.Rotation = FRotator(0.0f, Transform.Rotator().Yaw, 0.0f);
+	Agent.TargetRotation = Agent.Rotation;
+	Agent.AimingRotation = Agent.Rotation;
+	Agent.ArchetypeIndex = ArchetypeIndex;
+	Agent.Serial = Handle.Serial;
+	Agent.bActive = true;
+
+	return Handle;
+}
+
+void UAnonCrowdSubsystem::RemoveAgent(FAnonCrowdAgentHandle& Handle)
+{
+	if (FindAgent(Handle))
+	{
+		if (AAnonCharacter* Character = AgentActors[Handle.Index])
+		{
+			GetWorld()->GetSubsystem<UAnonCharacterPoolSubsystem>()->ReleaseCharacter(Character);
+			AgentActors[Handle.Index] = nullptr;
+			--NumHydrated;
+		}
+
+		Agents[Handle.Index].bActive = false;
+		Agents[Handle.Index].bHydrated = false;
+		FreeIndices.Add(Handle.Index);
+	}
+	Handle.Invalidate();
+}
+
+void UAnonCrowdSubsystem::SetAgentMovementInput(FAnonCrowdAgentHandle Handle, const FVector& MovementInput)
+{
+	// Fed to the actor every frame while hydrated, see SyncHydratedAgents
+	if (FAnonCrowdAgent* Agent = FindAgent(Handle))
+	{
+		Agent->MovementInput = MovementInput;
+	}
+}
+
+void UAnonCrowdSubsystem::SetAgentAimingRotation(FAnonCrowdAgentHandle Handle, const FRotator& AimingRotation)
+{
+	FAnonCrowdAgent* Agent = FindAgent(Handle);
+	if (!Agent) return;
+
+	Agent->AimingRotation = AimingRotation;
+	const AAnonCharacter* Character = AgentActors[Handle.Index];
+	if (Character && Character->GetController())
+	{
+		Character->GetController()->SetControlRotation(AimingRotation);
+	}
+}
+
+void UAnonCrowdSubsystem::SetAgentDesiredGait(FAnonCrowdAgentHandle Handle, EGait DesiredGait)
+{
+	FAnonCrowdAgent* Agent = FindAgent(Handle);
+	if (!Agent) return;
+
+	Agent->DesiredGait = DesiredGait;
+	if (AAnonCharacter* Character = AgentActors[Handle.Index])
+	{
+		Character->SetDesiredGait(DesiredGait);
+	}
+}
+
+void UAnonCrowdSubsystem::SetAgentStance(FAnonCrowdAgentHandle Handle, EStance Stance)
+{
+	FAnonCrowdAgent* Agent = FindAgent(Handle);
+	if (!Agent) return;
+
+	Agent->Stance = Stance;
+	if (AAnonCharacter* Character = AgentActors[Handle.Index])
+	{
+		Character->SetDesiredStance(Stance);
+		if (Stance == EStance::Crouching)
+		{
+			Character->Crouch();
+		}
+		else
+		{
+			Character->UnCrouch();
+		}
+	}
+}
+
+void UAnonCrowdSubsystem::SetAgentRotationMode(FAnonCrowdAgentHandle Handle, ERotationMode RotationMode)
+{
+	FAnonCrowdAgent* Agent = FindAgent(Handle);
+	if (!Agent) return;
+
+	Agent->RotationMode = RotationMode;
+	if (AAnonCharacter* Character = AgentActors[Handle.Index])
+	{
+		Character->SetDesiredRotationMode(RotationMode);
+		Character->SetRotationMode(RotationMode);
+	}
+}
+
+const FAnonCrowdAgent* UAnonCrowdSubsystem::GetAgent(FAnonCrowdAgentHandle Handle) const
+{
+	return const_cast<UAnonCrowdSubsystem*>(this)->FindAgent(Handle);
+}
+
+AAnonCharacter* UAnonCrowdSubsystem::GetAgentActor(FAnonCrowdAgentHandle Handle) const
+{
+	return GetAgent(Handle) ? AgentActors[Handle.Index].Get() : nullptr;
+}
+
+FAnonCrowdAgent* UAnonCrowdSubsystem::FindAgent(FAnonCrowdAgentHandle Handle)
+{
+	if (!Agents.IsValidIndex(Handle.Index)) return nullptr;
+
+	FAnonCrowdAgent& Agent = Agents[Handle.Index];
+	return Agent.bActive && Agent.Serial == Handle.Serial ? &Agent : nullptr;
+}
+
+int32 UAnonCrowdSubsystem::FindOrAddArchetype(TSubclassOf<AAnonCharacter> CharacterClass)
+{
+	if (!CharacterClass) return INDEX_NONE;
+
+	const int32 Existing = ArchetypeClasses.IndexOfByKey(CharacterClass);
+	if (Existing != INDEX_NONE) return Existing;
+
+	// Movement model of the class defaults, the row lookup happens once per class instead of once per agent
+	const AAnonCharacter* Defaults = CharacterClass->GetDefaultObject<AAnonCharacter>();
+	const FDataTableRowHandle& MovementModel = Defaults->GetMovementModel();
+	const FMovementStateSettings* Row = MovementModel.DataTable
+		                                    ? MovementModel.DataTable->FindRow<FMovementStateSettings>(
+			                                    MovementModel.RowName, CharacterClass->GetName())
+		                                    : nullptr;
+	if (!Row) return INDEX_NONE;
+
+	ArchetypeMovementData.Add(*Row);
+	ArchetypeHalfHeights.Add(Defaults->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+	return ArchetypeClasses.Add(CharacterClass);
+}
+
+// ==================== Simulation ==================== //
+
+void UAnonCrowdSubsystem::SimulateAgents(float DeltaTime)
+{
+	LOCOMOTION_SCOPE_CYCLE_COUNTER(STAT_AnonLocomotion_CrowdSimulate);
+	LOCOMOTION_BENCHMARK_SCOPE(Crowd);
+
+	const int32 BatchSize = FMath::Max(AgentsPerBatch, 1);
+	const int32 NumBatches = FMath::DivideAndRoundUp(Agents.Num(), BatchSize);
+	if (NumBatches == 0) return;
+
+	ParallelFor(NumBatches, [this, BatchSize, DeltaTime](int32 BatchIndex)
+	{
+		const int32 First = BatchIndex * BatchSize;
+		const int32 Last = FMath::Min(First + BatchSize, Agents.Num());
+		for (int32 i = First; i < Last; ++i)
+		{
+			FAnonCrowdAgent& Agent = Agents[i];
+			if (Agent.bActive && !Agent.bHydrated)
+			{
+				SimulateCrowdAgent(Agent, ArchetypeMovementData[Agent.ArchetypeIndex], MaxAcceleration,
+				                   BrakingDeceleration, DeltaTime);
+			}
+		}
+	}, NumBatches == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CrowdAgents, GetNumAgents() - NumHydrated);
+}
+
+void UAnonCrowdSubsystem::SyncHydratedAgents()
+{
+	if (NumHydrated == 0) return;
+
+	for (int32 i = 0; i < Agents.Num(); ++i)
+	{
+		FAnonCrowdAgent& Agent = Agents[i];
+		if (!Agent.bHydrated) continue;
+
+		AAnonCharacter* Character = AgentActors[i];
+		if (!IsValid(Character))
+		{
+			// Destroyed from outside, the agent continues from its last known state
+			AgentActors[i] = nullptr;
+			Agent.bHydrated = false;
+			--NumHydrated;
+			continue;
+		}
+
+		// Movement input is consumed every frame, the rest of the intent was forwarded when it changed
+		Character->AddMovementInput(Agent.MovementInput);
+		Character->WriteCrowdAgent(Agent);
+	}
+}
+
+void UAnonCrowdSubsystem::SnapAgentsToFloor()
+{
+	if (MaxFloorSnapsPerFrame <= 0 || Agents.Num() == 0) return;
+
+	// Static and dynamic world geometry only, agents don't stand on each other or on hydrated characters
+	const FCollisionObjectQueryParams ObjectParams(ECC_TO_BITFIELD(ECC_WorldStatic) | ECC_TO_BITFIELD(ECC_WorldDynamic));
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CrowdFloorTrace));
+	const UWorld* World = GetWorld();
+
+	const int32 NumSnaps = FMath::Min(MaxFloorSnapsPerFrame, Agents.Num());
+	int32 NumTraces = 0;
+	for (int32 i = 0; i < NumSnaps; ++i)
+	{
+		FloorSnapCursor = (FloorSnapCursor + 1) % Agents.Num();
+		FAnonCrowdAgent& Agent = Agents[FloorSnapCursor];
+		if (!Agent.bActive || Agent.bHydrated) continue;
+
+		// From the top of the capsule, walking up a slope puts the agent below its floor
+		const float HalfHeight = ArchetypeHalfHeights[Agent.ArchetypeIndex];
+		const FVector TraceStart = Agent.Location + FVector(0.0f, 0.0f, HalfHeight);
+		const FVector TraceEnd = Agent.Location - FVector(0.0f, 0.0f, HalfHeight + FloorSnapDistance);
+
+		FHitResult Hit;
+		if (World->LineTraceSingleByObjectType(Hit, TraceStart, TraceEnd, ObjectParams, QueryParams))
+		{
+			Agent.Location.Z = Hit.ImpactPoint.Z + HalfHeight;
+		}
+		++NumTraces;
+	}
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CrowdFloorTraces, NumTraces);
+}
+
+// ==================== Hydration ==================== //
+
+void UAnonCrowdSubsystem::GatherViewers()
+{
+	ViewerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController) continue;
+
+		// The server has no camera of remote players, their pawn is close enough
+		if (const APawn* Pawn = PlayerController->GetPawn())
+		{
+			ViewerLocations.Add(Pawn->GetActorLocation());
+		}
+		else if (PlayerController->PlayerCameraManager)
+		{
+			ViewerLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+	}
+}
+
+void UAnonCrowdSubsystem::UpdateHydration()
+{
+	GatherViewers();
+
+	const float HydrateDistSquared = FMath::Square(HydrateDistance);
+	const float DehydrateDistSquared = FMath::Square(HydrateDistance + DehydrateHysteresis);
+	int32 NumHydrations = 0;
+
+	for (int32 i = 0; i < Agents.Num(); ++i)
+	{
+		const FAnonCrowdAgent& Agent = Agents[i];
+		if (!Agent.bActive) continue;
+
+		float MinDistSquared = TNumericLimits<float>::Max();
+		for (const FVector& Viewer : ViewerLocations)
+		{
+			MinDistSquared = FMath::Min(MinDistSquared, static_cast<float>(FVector::DistSquared(Viewer, Agent.Location)));
+		}
+
+		if (Agent.bHydrated)
+		{
+			// Only grounded and idle characters fit back into the agent state
+			const AAnonCharacter* Character = AgentActors[i];
+			if (MinDistSquared > DehydrateDistSquared && Character->GetMovementState() == EMovementState::Grounded &&
+				Character->GetMovementAction() == EMovementAction::None)
+			{
+				Dehydrate(i);
+			}
+		}
+		else if (MinDistSquared < HydrateDistSquared && NumHydrated < MaxHydratedAgents &&
+			NumHydrations < MaxHydrationsPerFrame)
+		{
+			Hydrate(i);
+			++NumHydrations;
+		}
+	}
+}
+
+void UAnonCrowdSubsystem::Hydrate(int32 Index)
+{
+	FAnonCrowdAgent& Agent = Agents[Index];
+
+	UAnonCharacterPoolSubsystem* Pool = GetWorld()->GetSubsystem<UAnonCharacterPoolSubsystem>();
+	AAnonCharacter* Character = Pool->AcquireCharacter(ArchetypeClasses[Agent.ArchetypeIndex],
+	                                                   FTransform(Agent.Rotation, Agent.Location));
+	if (!Character) return;
+
+	// The movement component only simulates with a controller, pooled characters keep theirs
+	if (!Character->GetController())
+	{
+		Character->SpawnDefaultController();
+	}
+
+	Character->ApplyCrowdAgent(Agent);
+	AgentActors[Index] = Character;
+	Agent.bHydrated = true;
+	++NumHydrated;
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_CrowdHydrations, 1);
+}
+
+void UAnonCrowdSubsystem::Dehydrate(int32 Index)
+{
+	FAnonCrowdAgent& Agent = Agents[Index];
+	AAnonCharacter* Character = AgentActors[Index];
+
+	Character->WriteCrowdAgent(Agent);
+	GetWorld()->GetSubsystem<UAnonCharacterPoolSubsystem>()->ReleaseCharacter(Character);
+
+	AgentActors[Index] = nullptr;
+	Agent.bHydrated = false;
+	--NumHydrated;
+}
+
@@ -0,0 +1,551 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/FootstepFXSubsystem.h"
+
+#include "NiagaraFunctionLibrary.h"
+#include "Components/AudioComponent.h"
+#include "Components/DecalComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Data/LocomotionStruct.h"
+#include "Engine/DataTable.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Characters/AnonAnimInstance.h"
+#include "DrawDebugHelpers.h"
+#include "GameFramework/WorldSettings.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Library/FootstepSurfaceCache.h"
+#include "Library/LocomotionProfiling.h"
+#include "Sound/SoundBase.h"
+
+bool UFootstepFXSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nobody hears or sees footsteps on a dedicated server
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UFootstepFXSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Animation editor previews play footsteps too
+	return Super::DoesSupportWorldType(WorldType) || WorldType == EWorldType::EditorPreview ||
+		WorldType == EWorldType::GamePreview;
+}
+
+void UFootstepFXSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Component : AudioPool)
+	{
+		if (IsValid(Component))
+		{
+			Component->DestroyComponent();
+		}
+	}
+	for (UDecalComponent* Component : DecalPool)
+	{
+		if (IsValid(Component))
+		{
+			Component->DestroyComponent();
+		}
+	}
+	AudioPool.Empty();
+	DecalPool.Empty();
+	DecalExpireTimes.Empty();
+	QueuedRequests.Empty();
+	PendingTraces.Empty();
+	ReadyRequests.Empty();
+	FrameVoices.Empty();
+
+	for (const TSharedPtr<FStreamableHandle>& Handle : LoadHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->ReleaseHandle();
+		}
+	}
+	LoadHandles.Empty();
+	RegisteredTables.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFootstepFXSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Last frame's traces first, this frame's footsteps may still resolve right away from the foot IK
+	ConsumeTraces();
+	ResolveQueued();
+	ProcessQueue();
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 i = 0; i < DecalPool.Num(); ++i)
+	{
+		if (DecalExpireTimes[i] > 0.0 && DecalExpireTimes[i] <= Now)
+		{
+			DecalExpireTimes[i] = 0.0;
+			DecalPool[i]->SetVisibility(false);
+		}
+	}
+}
+
+TStatId UFootstepFXSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFootstepFXSubsystem, STATGROUP_Tickables);
+}
+
+void UFootstepFXSubsystem::RegisterTable(const UDataTable* Table)
+{
+	if (!Table || RegisteredTables.Contains(Table)) return;
+	RegisteredTables.Add(Table);
+
+	FFootstepSurfaceCache::Prime(Table);
+	if (Table->GetRowStruct() != FHitFX::StaticStruct()) return;
+
+	TArray<FSoftObjectPath> AssetPaths;
+	for (const TPair<FName, uint8*>& Pair : Table->GetRowMap())
+	{
+		const FHitFX* Row = reinterpret_cast<const FHitFX*>(Pair.Value);
+		for (const FSoftObjectPath& Path : {Row->Sound.ToSoftObjectPath(), Row->NiagaraSystem.ToSoftObjectPath(),
+		                                    Row->DecalMaterial.ToSoftObjectPath()})
+		{
+			if (!Path.IsNull())
+			{
+				AssetPaths.AddUnique(Path);
+			}
+		}
+	}
+
+	// The handle keeps the assets referenced for the lifetime of the world
+	if (AssetPaths.Num() > 0)
+	{
+		LoadHandles.Add(StreamableManager.RequestAsyncLoad(MoveTemp(AssetPaths), FStreamableDelegate(),
+		                                                   FStreamableManager::AsyncLoadHighPriority));
+	}
+}
+
+void UFootstepFXSubsystem::QueueFootstep(const FFootstepFXRequest& Request)
+{
+	if (!Request.Table.IsValid() || !Request.Mesh.IsValid()) return;
+
+	LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepsQueued, 1);
+	QueuedRequests.Add(Request);
+}
+
+void UFootstepFXSubsystem::ConsumeTraces()
+{
+	UWorld* World = GetWorld();
+	check(World);
+
+	for (int32 i = PendingTraces.Num() - 1; i >= 0; --i)
+	{
+		FPendingTrace& Pending = PendingTraces[i];
+
+		FTraceDatum Datum;
+		if (World->QueryTraceData(Pending.Handle, Datum))
+		{
+			const FHitResult* Hit = FHitResult::GetFirstBlockingHit(Datum.OutHits);
+			DrawDebugTrace(Pending.Request, Pending.Start, Pending.End, Hit);
+			if (Hit)
+			{
+				ResolveRequest(Pending.Request, Hit->Location, Hit->PhysMaterial.Get(), Hit->Component);
+			}
+			PendingTraces.RemoveAtSwap(i, 1, EAllowShrinking::No);
+		}
+		else if (GFrameCounter - Pending.FrameIssued > static_cast<uint64>(MaxTraceLatencyFrames))
+		{
+			PendingTraces.RemoveAtSwap(i, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+void UFootstepFXSubsystem::ResolveQueued()
+{
+	if (QueuedRequests.Num() == 0) return;
+
+	UWorld* World = GetWorld();
+	check(World);
+
+	for (FFootstepFXRequest& Request : QueuedRequests)
+	{
+		USkeletalMeshComponent* Mesh = Request.Mesh.Get();
+		const AActor* Owner = Mesh ? Mesh->GetOwner() : nullptr;
+		if (!Owner) continue;
+
+		// One socket lookup per footstep, the notify no longer does its own
+		const FTransform FootTransform = Mesh->GetSocketTransform(Request.FootSocketName);
+		Request.FootRotation = FootTransform.Rotator();
+		Request.OwnerTransform = Owner->GetTransform();
+
+		const FVector TraceStart = FootTransform.GetLocation();
+		const FVector TraceEnd = TraceStart - Owner->GetActorUpVector() * Request.TraceLength;
+
+		// The foot IK traces the visibility channel every frame, most footsteps land right on that hit.
+		// Anim worker threads are done by the time tickable objects tick, so reading it here is safe
+		if (Request.TraceChannel == ECC_Visibility)
+		{
+			const UAnonAnimInstance* AnimInstance = Cast<UAnonAnimInstance>(Mesh->GetAnimInstance());
+			FFootGroundHit GroundHit;
+			if (AnimInstance && AnimInstance->FindFootGroundHit(TraceStart, FootIKHitRadius, Request.TraceLength,
+			                                                    MaxFootIKHitAge, GroundHit))
+			{
+				LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepTraceReused, 1);
+				ResolveRequest(Request, GroundHit.Location, GroundHit.PhysMaterial.Get(), GroundHit.Component);
+				continue;
+			}
+		}
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(FootstepTrace), true, Owner);
+		Params.bReturnPhysicalMaterial = true;
+		for (const AActor* Child : Owner->Children)
+		{
+			Params.AddIgnoredActor(Child);
+		}
+
+		LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_TracesIssued, 1);
+		const FTraceHandle Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd,
+		                                                           Request.TraceChannel, Params);
+		PendingTraces.Add({MoveTemp(Request), Handle, GFrameCounter, TraceStart, TraceEnd});
+	}
+
+	// Keeps its allocation for the next frame
+	QueuedRequests.Reset();
+}
+
+void UFootstepFXSubsystem::ResolveRequest(FFootstepFXRequest& Request, const FVector& HitLocation,
+                                          const UPhysicalMaterial* PhysMaterial,
+                                          const TWeakObjectPtr<UPrimitiveComponent>& HitComponent)
+{
+	const UDataTable* Table = Request.Table.Get();
+	if (!PhysMaterial || !Table) return;
+
+	// O(1), the default surface row is already baked into surfaces without their own row
+	Request.HitFX = FFootstepSurfaceCache::Find(Table, PhysMaterial->SurfaceType);
+	if (!Request.HitFX) return;
+
+	Request.HitLocation = HitLocation;
+	Request.HitComponent = HitComponent;
+	ReadyRequests.Add(MoveTemp(Request));
+}
+
+void UFootstepFXSubsystem::DrawDebugTrace(const FFootstepFXRequest& Request, const FVector& Start, const FVector& End,
+                                          const FHitResult* Hit) const
+{
+#if ENABLE_DRAW_DEBUG
+	if (Request.DrawDebugType == EDrawDebugTrace::None) return;
+
+	// Same look as UKismetSystemLibrary::LineTraceSingle
+	const bool bPersistent = Request.DrawDebugType == EDrawDebugTrace::Persistent;
+	const float LifeTime = Request.DrawDebugType == EDrawDebugTrace::ForDuration ? 5.0f : 0.0f;
+	if (Hit)
+	{
+		DrawDebugLine(GetWorld(), Start, Hit->ImpactPoint, FColor::Red, bPersistent, LifeTime);
+		DrawDebugLine(GetWorld(), Hit->ImpactPoint, End, FColor::Green, bPersistent, LifeTime);
+		DrawDebugPoint(GetWorld(), Hit->ImpactPoint, 16.0f, FColor::Red, bPersistent, LifeTime);
+	}
+	else
+	{
+		DrawDebugLine(GetWorld(), Start, End, FColor::Red, bPersistent, LifeTime);
+	}
+#endif
+}
+
+void UFootstepFXSubsystem::UpdateSignificance(FFootstepFXRequest& Request) const
+{
+	Request.bVisible = Request.Mesh->WasRecentlyRendered(0.25f);
+
+	// No local listener (e.g. an editor preview without a player), keep everything
+	if (ListenerLocations.Num() == 0)
+	{
+		Request.DistanceToListener = 0.0f;
+		Request.Significance = 1.0f;
+		return;
+	}
+
+	float MinDistSquared = TNumericLimits<float>::Max();
+	for (const FVector& Listener : ListenerLocations)
+	{
+		MinDistSquared = FMath::Min(MinDistSquared, static_cast<float>(FVector::DistSquared(Listener, Request.HitLocation)));
+	}
+	Request.DistanceToListener = FMath::Sqrt(MinDistSquared);
+
+	const float DistanceFactor = 1.0f - FMath::Clamp(Request.DistanceToListener / MaxSoundDistance, 0.0f, 1.0f);
+	Request.Significance = Request.bVisible ? DistanceFactor : DistanceFactor * 0.5f;
+}
+
+void UFootstepFXSubsystem::ProcessQueue()
+{
+	FrameVoices.Reset();
+	if (ReadyRequests.Num() == 0) return;
+
+	ListenerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			ListenerLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+	}
+
+	for (FFootstepFXRequest& Request : ReadyRequests)
+	{
+		if (Request.Mesh.IsValid())
+		{
+			UpdateSignificance(Request);
+		}
+		else
+		{
+			Request.Significance = -1.0f;
+		}
+	}
+
+	// Most significant first, so the closest characters always get the budget
+	ReadyRequests.Sort([](const FFootstepFXRequest& A, const FFootstepFXRequest& B)
+	{
+		return A.Significance > B.Significance;
+	});
+
+	int32 NumSounds = 0;
+	int32 NumNiagara = 0;
+	int32 NumDecals = 0;
+
+	for (const FFootstepFXRequest& Request : ReadyRequests)
+	{
+		if (Request.Significance < 0.0f) continue;
+
+		const FHitFX* HitFX = Request.HitFX;
+		const bool bHiddenCulled = bCullHiddenVisualFX && !Request.bVisible;
+
+		// Soft pointers resolve only once the async load finished, never load here
+		if (Request.bSpawnSound)
+		{
+			if (USoundBase* Sound = HitFX->Sound.Get())
+			{
+				if (Request.DistanceToListener > MaxSoundDistance)
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepCulled, 1);
+				}
+				else if (TryCoalesceSound(Request, Sound))
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepCoalesced, 1);
+				}
+				else if (NumSounds >= MaxSoundsPerFrame)
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepOverBudget, 1);
+				}
+				else if (UAudioComponent* Component = PlaySound(Request, Sound))
+				{
+					++NumSounds;
+					FrameVoices.Add({Sound, Request.HitLocation, Component, Request.VolumeMultiplier});
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepSounds, 1);
+				}
+			}
+		}
+
+		if (Request.bSpawnNiagara)
+		{
+			if (UNiagaraSystem* System = HitFX->NiagaraSystem.Get())
+			{
+				if (bHiddenCulled || Request.DistanceToListener > MaxNiagaraDistance)
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepCulled, 1);
+				}
+				else if (NumNiagara >= MaxNiagaraPerFrame)
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepOverBudget, 1);
+				}
+				else
+				{
+					++NumNiagara;
+					PlayNiagara(Request, System);
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepNiagara, 1);
+				}
+			}
+		}
+
+		if (Request.bSpawnDecal)
+		{
+			if (UMaterialInterface* Material = HitFX->DecalMaterial.Get())
+			{
+				if (bHiddenCulled || Request.DistanceToListener > MaxDecalDistance)
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepCulled, 1);
+				}
+				else if (NumDecals >= MaxDecalsPerFrame)
+				{
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepOverBudget, 1);
+				}
+				else
+				{
+					++NumDecals;
+					PlayDecal(Request, Material);
+					LOCOMOTION_INC_COUNTER(STAT_AnonLocomotion_FootstepDecals, 1);
+				}
+			}
+		}
+	}
+
+	// Keeps its allocation for the next frame
+	ReadyRequests.Reset();
+}
+
+bool UFootstepFXSubsystem::TryCoalesceSound(const FFootstepFXRequest& Request, const USoundBase* Sound)
+{
+	const float RadiusSquared = FMath::Square(CoalesceRadius);
+	for (FCoalescedVoice& Voice : FrameVoices)
+	{
+		if (Voice.Sound != Sound || FVector::DistSquared(Voice.Location, Request.HitLocation) > RadiusSquared)
+		{
+			continue;
+		}
+
+		// Two steps at once sound louder, not twice as loud
+		Voice.Volume = FMath::Min(Voice.Volume + Request.VolumeMultiplier * 0.25f, MaxCoalescedVolume);
+		if (UAudioComponent* Component = Voice.Component.Get())
+		{
+			Component->SetVolumeMultiplier(Voice.Volume);
+		}
+		return true;
+	}
+	return false;
+}
+
+UAudioComponent* UFootstepFXSubsystem::PlaySound(const FFootstepFXRequest& Request, USoundBase* Sound)
+{
+	const FHitFX* HitFX = Request.HitFX;
+
+	UAudioComponent* Component = AcquireAudioComponent();
+	if (!Component) return nullptr;
+
+	if (HitFX->SoundSpawnType == ESpawnType::Attached)
+	{
+		Component->AttachToComponent(Request.Mesh.Get(), FAttachmentTransformRules::KeepRelativeTransform,
+		                             Request.FootSocketName);
+		if (HitFX->SoundAttachmentType == EAttachLocation::KeepWorldPosition)
+		{
+			Component->SetWorldLocationAndRotation(HitFX->SoundLocationOffset, HitFX->SoundRotationOffset);
+		}
+		else
+		{
+			Component->SetRelativeLocationAndRotation(HitFX->SoundLocationOffset, HitFX->SoundRotationOffset);
+		}
+	}
+	else
+	{
+		Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		Component->SetWorldLocationAndRotation(Request.HitLocation + HitFX->SoundLocationOffset,
+		                                       HitFX->SoundRotationOffset);
+	}
+
+	Component->SetSound(Sound);
+	Component->SetVolumeMultiplier(Request.VolumeMultiplier);
+	Component->SetPitchMultiplier(Request.PitchMultiplier);
+	Component->SetIntParameter(Request.SoundParameterName, static_cast<int32>(Request.FootstepType));
+
+	// Lets the audio mixer drop far footsteps before close ones when voices run out
+	Component->bOverridePriority = true;
+	Component->Priority = FMath::Lerp(0.25f, 1.0f, Request.Significance);
+
+	Component->Play();
+	return Component;
+}
+
+void UFootstepFXSubsystem::PlayNiagara(const FFootstepFXRequest& Request, UNiagaraSystem* System) const
+{
+	const FHitFX* HitFX = Request.HitFX;
+
+	// AutoRelease hands the component back to the world's Niagara pool once the effect completes
+	switch (HitFX->NiagaraSpawnType)
+	{
+	case ESpawnType::Location:
+		UNiagaraFunctionLibrary::SpawnSystemAtLocation(
+			GetWorld(), System, Request.HitLocation + Request.OwnerTransform.TransformVector(HitFX->DecalLocationOffset),
+			Request.FootRotation + HitFX->NiagaraRotationOffset, FVector::OneVector, true, true,
+			ENCPoolMethod::AutoRelease);
+		break;
+
+	case ESpawnType::Attached:
+		UNiagaraFunctionLibrary::SpawnSystemAttached(
+			System, Request.Mesh.Get(), Request.FootSocketName, HitFX->NiagaraLocationOffset,
+			HitFX->NiagaraRotationOffset, HitFX->NiagaraAttachmentType, true, true, ENCPoolMethod::AutoRelease);
+		break;
+	}
+}
+
+void UFootstepFXSubsystem::PlayDecal(const FFootstepFXRequest& Request, UMaterialInterface* Material)
+{
+	const FHitFX* HitFX = Request.HitFX;
+
+	const int32 Index = AcquireDecal();
+	if (Index == INDEX_NONE) return;
+	UDecalComponent* Component = DecalPool[Index];
+
+	const FVector Location = Request.HitLocation + Request.OwnerTransform.TransformVector(HitFX->DecalLocationOffset);
+	const FRotator Rotation = Request.FootRotation + HitFX->DecalRotationOffset;
+
+	Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	if (HitFX->DecalSpawnType == ESpawnType::Attached && Request.HitComponent.IsValid())
+	{
+		Component->AttachToComponent(Request.HitComponent.Get(), FAttachmentTransformRules::KeepWorldTransform);
+	}
+
+	Component->SetDecalMaterial(Material);
+	Component->DecalSize = HitFX->DecalSize * Request.DecalScale;
+	Component->SetVisibility(true);
+	Component->MarkRenderStateDirty();
+
+	DecalExpireTimes[Index] = HitFX->DecalLifeSpan > 0.0f ? GetWorld()->GetTimeSeconds() + HitFX->DecalLifeSpan : 0.0;
+}
+
+UAudioComponent* UFootstepFXSubsystem::AcquireAudioComponent()
+{
+	// Grow until the pool is full (warm up), afterwards only recycle
+	if (AudioPool.Num() < AudioPoolSize)
+	{
+		UAudioComponent* Component = NewObject<UAudioComponent>(GetWorld()->GetWorldSettings());
+		Component->bAutoActivate = false;
+		Component->bAutoDestroy = false;
+		Component->bAllowSpatialization = true;
+		Component->RegisterComponentWithWorld(GetWorld());
+		return AudioPool.Add_GetRef(Component);
+	}
+
+	if (AudioPool.Num() == 0) return nullptr;
+
+	// Prefer a finished voice, else steal the oldest one in ring order
+	for (int32 i = 0; i < AudioPool.Num(); ++i)
+	{
+		const int32 Index = (NextAudio + i) % AudioPool.Num();
+		if (!AudioPool[Index]->IsPlaying())
+		{
+			NextAudio = (Index + 1) % AudioPool.Num();
+			return AudioPool[Index];
+		}
+	}
+
+	UAudioComponent* Oldest = AudioPool[NextAudio];
+	NextAudio = (NextAudio + 1) % AudioPool.Num();
+	Oldest->Stop();
+	return Oldest;
+}
+
+int32 UFootstepFXSubsystem::AcquireDecal()
+{
+	if (DecalPool.Num() < DecalPoolSize)
+	{
+		UDecalComponent* Component = NewObject<UDecalComponent>(GetWorld()->GetWorldSettings());
+		Component->bAllowAnyoneToDestroyMe = true;
+		Component->SetFadeScreenSize(0.01f);
+		Component->RegisterComponentWithWorld(GetWorld());
+		DecalExpireTimes.Add(0.0);
+		return DecalPool.Add(Component);
+	}
+
+	if (DecalPool.Num() == 0) return INDEX_NONE;
+
+	// Ring order is spawn order, so this recycles the oldest decal
+	const int32 Oldest = NextDecal;
+	NextDecal = (NextDecal + 1) % DecalPool.Num();
+	return Oldest;
+}
@@ -0,0 +1,88 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/LocomotionStateSubsystem.h"
+
+#include "Characters/AnonCharacter.h"
+
+void ULocomotionStateSubsystem::Deinitialize()
+{
+	// Characters may outlive the pool during world teardown, don't leave them pointing into freed blocks. Unregistering
+	// releases the block, so collect them before touching ActiveStates
+	TArray<AAnonCharacter*> RegisteredOwners;
+	for (TConstSetBitIterator<> It(ActiveStates); It; ++It)
+	{
+		if (AAnonCharacter* Owner = Owners[It.GetIndex()].Get(true))
+		{
+			RegisteredOwners.Add(Owner);
+		}
+	}
+	for (AAnonCharacter* Owner : RegisteredOwners)
+	{
+		Owner->UnregisterRuntimeState();
+	}
+
+	States.Empty();
+	ActiveStates.Empty();
+	FreeIndices.Empty();
+	Owners.Empty();
+
+	Super::Deinitialize();
+}
+
+FLocomotionStateHandle ULocomotionStateSubsystem::Acquire(const FLocomotionRuntimeState& InitialState,
+                                                          AAnonCharacter* Owner)
+{
+	check(IsInGameThread());
+
+	FLocomotionStateHandle Handle;
+	if (FreeIndices.Num() > 0)
+	{
+		Handle.Index = FreeIndices.Pop(EAllowShrinking::No);
+		States[Handle.Index] = InitialState;
+		ActiveStates[Handle.Index] = true;
+		Owners[Handle.Index] = Owner;
+	}
+	else
+	{
+		Handle.Index = States.AddElement(InitialState);
+		ActiveStates.Add(true);
+		Owners.Add(Owner);
+	}
+
+	return Handle;
+}
+
+void ULocomotionStateSubsystem::Release(FLocomotionStateHandle& Handle)
+{
+	check(IsInGameThread());
+
+	if (!Handle.IsValid() || !ActiveStates.IsValidIndex(Handle.Index) || !ActiveStates[Handle.Index])
+	{
+		Handle.Invalidate();
+		return;
+	}
+
+	ActiveStates[Handle.Index] = false;
+	Owners[Handle.Index].Reset();
+	FreeIndices.Add(Handle.Index);
+	Handle.Invalidate();
+}
+
+void ULocomotionStateSubsystem::ForEachActiveState(TFunctionRef<void(FLocomotionStateHandle, FLocomotionRuntimeState&)> Func)
+{
+	FLocomotionStateHandle Handle;
+	for (TConstSetBitIterator<> It(ActiveStates); It; ++It)
+	{
+		Handle.Index = It.GetIndex();
+		Func(Handle, States[Handle.Index]);
+	}
+}
+
+void ULocomotionStateSubsystem::TakeSnapshot(TArray<FLocomotionRuntimeState>& OutSnapshot) const
+{
+	OutSnapshot.Reset(GetNumActiveStates());
+	for (TConstSetBitIterator<> It(ActiveStates); It; ++It)
+	{
+		OutSnapshot.Add(States[It.GetIndex()]);
+	}
+}
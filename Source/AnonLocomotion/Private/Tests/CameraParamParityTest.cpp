@@ -0,0 +1,159 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Camera/AnonCameraSettings.h"
+#include "Camera/AnonPlayerCameraManager.h"
+#include "Characters/AnonCharacter.h"
+#include "GameFramework/PlayerController.h"
+#include "Library/CameraParamEvaluator.h"
+#include "Tests/LocomotionTestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAnonCameraParamParityTest, "AnonLocomotion.Camera.EvaluatorParity",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+namespace
+{
+	/** A state held this long has finished blending on both paths */
+	constexpr float SettleTime = 2.0f;
+	constexpr float ParamTolerance = 0.1f;
+
+	struct FCameraSample
+	{
+		FCameraStateKey Key;
+		FCameraBehaviorParams Params;
+		float DeltaTime = 0.0f;
+		bool bSettled = false;
+	};
+
+	uint32 GetKeyHash(const FCameraStateKey& Key)
+	{
+		return static_cast<uint32>(Key.MovementState)
+			| static_cast<uint32>(Key.Gait) << 4
+			| static_cast<uint32>(Key.Stance) << 8
+			| static_cast<uint32>(Key.RotationMode) << 12
+			| static_cast<uint32>(Key.ViewMode) << 16
+			| static_cast<uint32>(Key.bRightShoulder) << 20;
+	}
+
+	FString KeyToString(const FCameraStateKey& Key)
+	{
+		return FString::Printf(TEXT("%s %s %s %s %s %s"), *UEnum::GetValueAsString(Key.MovementState),
+		                       *UEnum::GetValueAsString(Key.Gait), *UEnum::GetValueAsString(Key.Stance),
+		                       *UEnum::GetValueAsString(Key.RotationMode), *UEnum::GetValueAsString(Key.ViewMode),
+		                       Key.bRightShoulder ? TEXT("Right") : TEXT("Left"));
+	}
+
+	bool ParamsNearlyEqual(const FCameraBehaviorParams& A, const FCameraBehaviorParams& B)
+	{
+		return A.PivotLagSpeed.Equals(B.PivotLagSpeed, ParamTolerance)
+			&& A.PivotOffset.Equals(B.PivotOffset, ParamTolerance)
+			&& A.CameraOffset.Equals(B.CameraOffset, ParamTolerance)
+			&& FMath::IsNearlyEqual(A.RotationLagSpeed, B.RotationLagSpeed, ParamTolerance)
+			&& FMath::IsNearlyEqual(A.Weight_FirstPerson, B.Weight_FirstPerson, ParamTolerance)
+			&& FMath::IsNearlyEqual(A.Override_Debug, B.Override_Debug, ParamTolerance);
+	}
+
+	/** Rule constrained on every key, so no other rule can shadow it */
+	FCameraStateRule MakeExactRule(const FCameraStateKey& Key, const FCameraBehaviorParams& Params)
+	{
+		FCameraStateRule Rule;
+		Rule.MovementStates = 1 << static_cast<uint8>(Key.MovementState);
+		Rule.Gaits = 1 << static_cast<uint8>(Key.Gait);
+		Rule.Stances = 1 << static_cast<uint8>(Key.Stance);
+		Rule.RotationModes = 1 << static_cast<uint8>(Key.RotationMode);
+		Rule.ViewModes = 1 << static_cast<uint8>(Key.ViewMode);
+		Rule.bMatchShoulder = true;
+		Rule.bRightShoulder = Key.bRightShoulder;
+		Rule.Params = Params;
+		return Rule;
+	}
+}
+
+/**
+ * Replays the scripted inputs with the camera reading the ABP_Camera curves, turns the settled curve values into one
+ * rule per state, then runs the evaluator over the same state sequence. Every settled frame must match: a state
+ * settling on different curve values, or the evaluator not reaching them, fails the test.
+ */
+bool FAnonCameraParamParityTest::RunTest(const FString& Parameters)
+{
+	FLocomotionTestWorld TestWorld;
+	if (!TestTrue(TEXT("Demo level loaded"), TestWorld.IsValid())) return false;
+
+	AAnonCharacter* Character = TestWorld.SpawnCharacter(FVector::ZeroVector, true);
+	const APlayerController* PlayerController = TestWorld.GetPlayerController();
+	const AAnonPlayerCameraManager* CameraManager =
+		PlayerController ? Cast<AAnonPlayerCameraManager>(PlayerController->PlayerCameraManager) : nullptr;
+	if (!TestNotNull(TEXT("Character"), Character) || !TestNotNull(TEXT("Camera manager"), CameraManager)) return false;
+	if (!TestFalse(TEXT("Camera reads the anim curves"), CameraManager->UsesCameraParamEvaluator())) return false;
+
+	// Legacy path
+	const FLocomotionInputRecording Recording = FLocomotionTestWorld::MakeScriptedRecording();
+	TArray<FCameraSample> Samples;
+	Samples.Reserve(Recording.Frames.Num());
+
+	float KeyAge = 0.0f;
+	bool bCurvesRead = false;
+	for (const FLocomotionInputFrame& Frame : Recording.Frames)
+	{
+		TestWorld.ReplayFrame(Frame, MakeArrayView(&Character, 1));
+
+		FCameraSample Sample;
+		Sample.Key = AAnonPlayerCameraManager::MakeCameraStateKey(*Character);
+		Sample.Params = CameraManager->GetCameraParams();
+		Sample.DeltaTime = Frame.DeltaTime;
+
+		const bool bSameKey = Samples.Num() > 0 && GetKeyHash(Samples.Last().Key) == GetKeyHash(Sample.Key);
+		KeyAge = bSameKey ? KeyAge + Frame.DeltaTime : 0.0f;
+		Sample.bSettled = KeyAge >= SettleTime;
+
+		bCurvesRead |= !ParamsNearlyEqual(Sample.Params, FCameraBehaviorParams());
+		Samples.Add(Sample);
+	}
+	if (!TestTrue(TEXT("ABP_Camera drove the camera"), bCurvesRead)) return false;
+
+	// First settled value of every state becomes its rule
+	UAnonCameraSettings* Settings = NewObject<UAnonCameraSettings>(GetTransientPackage());
+	TSet<uint32> SettledKeys;
+	for (const FCameraSample& Sample : Samples)
+	{
+		bool bAlreadyInSet = false;
+		if (Sample.bSettled)
+		{
+			SettledKeys.Add(GetKeyHash(Sample.Key), &bAlreadyInSet);
+			if (!bAlreadyInSet)
+			{
+				Settings->Rules.Add(MakeExactRule(Sample.Key, Sample.Params));
+			}
+		}
+	}
+	TestTrue(TEXT("Several camera states settled"), SettledKeys.Num() > 1);
+
+	// Evaluator path over the same states
+	FCameraParamEvaluator Evaluator;
+	Evaluator.Reset(*Settings, Samples[0].Key);
+
+	int32 NumCompared = 0;
+	for (int32 i = 0; i < Samples.Num(); ++i)
+	{
+		const FCameraSample& Sample = Samples[i];
+		const bool bKeyChanged = i > 0 && GetKeyHash(Samples[i - 1].Key) != GetKeyHash(Sample.Key);
+		const FCameraBehaviorParams& Params = Evaluator.Update(*Settings, Sample.Key, bKeyChanged, Sample.DeltaTime);
+
+		if (!Sample.bSettled) continue;
+
+		++NumCompared;
+		if (!ParamsNearlyEqual(Params, Sample.Params))
+		{
+			AddError(FString::Printf(TEXT("Frame %d, %s: evaluator and ABP_Camera parameters differ"), i,
+			                         *KeyToString(Sample.Key)));
+		}
+	}
+	TestTrue(TEXT("Settled frames compared"), NumCompared > 0);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,65 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequence.h"
+#include "Characters/AnonAnimInstance.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/UObjectIterator.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAnonDynamicMontagePoolTest, "AnonLocomotion.Animation.DynamicMontagePool",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FAnonDynamicMontagePoolTest::RunTest(const FString& Parameters)
+{
+	// Rooted, garbage collection runs in between
+	const TStrongObjectPtr<UAnonAnimInstance> AnimInstance(NewObject<UAnonAnimInstance>(GetTransientPackage()));
+	const TStrongObjectPtr<UAnimSequence> TurnAnimation(NewObject<UAnimSequence>(GetTransientPackage()));
+	const FName SlotName(TEXT("(Turn/Rotate)"));
+
+	auto CountMontages = []
+	{
+		int32 NumMontages = 0;
+		for (TObjectIterator<UAnimMontage> It; It; ++It)
+		{
+			++NumMontages;
+		}
+		return NumMontages;
+	};
+
+	// Replaying the same turn must not create another montage
+	UAnimMontage* First = AnimInstance->FindOrCreatePooledMontage(TurnAnimation.Get(), SlotName, 0.2f, 0.2f, 1);
+	UAnimMontage* Second = AnimInstance->FindOrCreatePooledMontage(TurnAnimation.Get(), SlotName, 0.2f, 0.2f, 1);
+	if (!TestNotNull(TEXT("Pooled montage"), First)) return false;
+
+	TestEqual(TEXT("Replay reuses the pooled montage"), Second, First);
+	TestEqual(TEXT("Montages after replay"), AnimInstance->GetNumPooledMontages(), 1);
+
+	// No UAnimMontage object is created by replays, and the pooled one survives garbage collection
+	const int32 NumMontagesBefore = CountMontages();
+	for (int32 i = 0; i < 100; ++i)
+	{
+		AnimInstance->FindOrCreatePooledMontage(TurnAnimation.Get(), SlotName, 0.2f, 0.2f, 1);
+	}
+	TestEqual(TEXT("UAnimMontage objects after 100 replays"), CountMontages(), NumMontagesBefore);
+
+	const TWeakObjectPtr<UAnimMontage> WeakFirst = First;
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	TestTrue(TEXT("Pooled montage survives garbage collection"), WeakFirst.IsValid());
+	TestEqual(TEXT("Replay after garbage collection"),
+	          AnimInstance->FindOrCreatePooledMontage(TurnAnimation.Get(), SlotName, 0.2f, 0.2f, 1), First);
+
+	// Other blend times get their own montage and leave the one that may still be blending out untouched
+	UAnimMontage* Slower = AnimInstance->FindOrCreatePooledMontage(TurnAnimation.Get(), SlotName, 0.2f, 0.5f, 1);
+	TestNotEqual(TEXT("Other blend times use another montage"), Slower, First);
+	TestEqual(TEXT("Blend out of the first montage"), First->BlendOut.GetBlendTime(), 0.2f);
+	TestEqual(TEXT("Blend out trigger time"), First->BlendOutTriggerTime, 0.f);
+	TestEqual(TEXT("Montages after other blend times"), AnimInstance->GetNumPooledMontages(), 2);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,121 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Characters/AnonCharacter.h"
+#include "Tests/LocomotionTestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAnonEarlyBlendOutTest, "AnonLocomotion.Animation.EarlyBlendOut",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+namespace
+{
+	constexpr float DeltaTime = 1.0f / 60.0f;
+
+	FEarlyBlendOutCondition MakeCondition(UAnimInstance* AnimInstance, UAnimMontage* Montage)
+	{
+		FEarlyBlendOutCondition Condition;
+		Condition.AnimInstance = AnimInstance;
+		Condition.Montage = Montage;
+		return Condition;
+	}
+
+	/** Movement input along the character's forward axis */
+	FLocomotionInputFrame MakeMoveFrame()
+	{
+		FLocomotionInputFrame Frame;
+		Frame.DeltaTime = DeltaTime;
+		Frame.Events.Add({ELocomotionInputAction::Move, FVector2D(0.0, 1.0)});
+		return Frame;
+	}
+}
+
+bool FAnonEarlyBlendOutTest::RunTest(const FString& Parameters)
+{
+	FLocomotionTestWorld TestWorld;
+	if (!TestTrue(TEXT("Demo level loaded"), TestWorld.IsValid())) return false;
+
+	AAnonCharacter* Character = TestWorld.SpawnCharacter();
+	if (!TestNotNull(TEXT("Character"), Character)) return false;
+
+	UAnimInstance* AnimInstance = Character->GetMesh()->GetAnimInstance();
+	UAnimMontage* RollMontage = Character->GetRollAnimation();
+	if (!TestNotNull(TEXT("Anim instance"), AnimInstance) || !TestNotNull(TEXT("Roll montage"), RollMontage)) return false;
+
+	// Without its notifies, so only the windows registered here can stop it
+	UAnimMontage* Montage = DuplicateObject<UAnimMontage>(RollMontage, GetTransientPackage());
+	Montage->Notifies.Reset();
+
+	// Land on the floor of the level first
+	for (int32 i = 0; i < 60; ++i)
+	{
+		TestWorld.Tick(DeltaTime);
+	}
+	TestEqual(TEXT("Grounded before the windows"), Character->GetMovementState(), EMovementState::Grounded);
+
+	//-- Condition holding when registered --//
+
+	AnimInstance->Montage_Play(Montage);
+	FEarlyBlendOutCondition Grounded = MakeCondition(AnimInstance, nullptr);
+	Grounded.bCheckMovementState = true;
+	Grounded.MovementStateEquals = EMovementState::Grounded;
+
+	Character->RegisterEarlyBlendOut(Grounded);
+	TestFalse(TEXT("A window without montage stops nothing"), AnimInstance->Montage_GetIsStopped(Montage));
+
+	Grounded.Montage = Montage;
+	Character->RegisterEarlyBlendOut(Grounded);
+	TestTrue(TEXT("Stopped when the condition already holds"), AnimInstance->Montage_GetIsStopped(Montage));
+
+	//-- Movement state change --//
+
+	AnimInstance->Montage_Play(Montage);
+	FEarlyBlendOutCondition InAir = MakeCondition(AnimInstance, Montage);
+	InAir.bCheckMovementState = true;
+	InAir.MovementStateEquals = EMovementState::InAir;
+
+	Character->RegisterEarlyBlendOut(InAir);
+	TestFalse(TEXT("Playing while grounded"), AnimInstance->Montage_GetIsStopped(Montage));
+	Character->SetMovementState(EMovementState::InAir);
+	TestTrue(TEXT("Stopped when in air"), AnimInstance->Montage_GetIsStopped(Montage));
+	Character->SetMovementState(EMovementState::Grounded);
+
+	//-- Stance change --//
+
+	AnimInstance->Montage_Play(Montage);
+	FEarlyBlendOutCondition Crouching = MakeCondition(AnimInstance, Montage);
+	Crouching.bCheckStance = true;
+	Crouching.StanceEquals = EStance::Crouching;
+
+	Character->RegisterEarlyBlendOut(Crouching);
+	TestFalse(TEXT("Playing while standing"), AnimInstance->Montage_GetIsStopped(Montage));
+	Character->SetStance(EStance::Crouching);
+	TestTrue(TEXT("Stopped when crouching"), AnimInstance->Montage_GetIsStopped(Montage));
+	Character->SetStance(EStance::Standing);
+
+	//-- Movement input started --//
+
+	AnimInstance->Montage_Play(Montage);
+	FEarlyBlendOutCondition MovementInput = MakeCondition(AnimInstance, Montage);
+	MovementInput.bCheckMovementInput = true;
+
+	Character->RegisterEarlyBlendOut(MovementInput);
+	TestWorld.Tick(DeltaTime);
+	TestFalse(TEXT("Playing without movement input"), AnimInstance->Montage_GetIsStopped(Montage));
+
+	const FLocomotionInputFrame MoveFrame = MakeMoveFrame();
+	for (int32 i = 0; i < 10 && !Character->HasMovementInput(); ++i)
+	{
+		TestWorld.ReplayFrame(MoveFrame, MakeArrayView(&Character, 1));
+	}
+	TestTrue(TEXT("Movement input started"), Character->HasMovementInput());
+	TestTrue(TEXT("Stopped when movement input starts"), AnimInstance->Montage_GetIsStopped(Montage));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,186 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/LocomotionTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "EngineUtils.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Characters/AnonCharacter.h"
+#include "Engine/Engine.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/App.h"
+
+const TCHAR* FLocomotionTestWorld::DemoLevel = TEXT("/AnonLocomotion/Levels/ALS_DemoLevel");
+const TCHAR* FLocomotionTestWorld::CharacterClassPath =
+	TEXT("/AnonLocomotion/Characters/Anon/Blueprints/BP_AnimMan.BP_AnimMan_C");
+const TCHAR* FLocomotionTestWorld::PlayerControllerClassPath =
+	TEXT("/AnonLocomotion/Controller/BP_AnonPlayerController.BP_AnonPlayerController_C");
+const TCHAR* FLocomotionTestWorld::CameraManagerClassPath =
+	TEXT("/AnonLocomotion/Camera/BP_AnonPlayerCameraManager.BP_AnonPlayerCameraManager_C");
+
+FLocomotionTestWorld::FLocomotionTestWorld(const TCHAR* MapName)
+{
+	UPackage* Package = LoadPackage(nullptr, MapName, LOAD_None);
+	World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!World) return;
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true));
+	}
+
+	World->UpdateWorldComponents(true, true);
+	World->InitializeActorsForPlay(FURL());
+
+	// Same as the benchmark commandlet: no game instance, so BeginPlay goes through the world settings
+	World->BeginPlay();
+	if (!World->HasBegunPlay())
+	{
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Origin = It->GetActorTransform();
+		break;
+	}
+}
+
+FLocomotionTestWorld::~FLocomotionTestWorld()
+{
+	if (!World) return;
+
+	World->DestroyWorld(false);
+	GEngine->DestroyWorldContext(World);
+	World->RemoveFromRoot();
+
+	CollectGarbage(RF_NoFlags);
+}
+
+AAnonCharacter* FLocomotionTestWorld::SpawnCharacter(const FVector& Offset, bool bWithPlayer)
+{
+	UClass* CharacterClass = LoadClass<AAnonCharacter>(nullptr, CharacterClassPath);
+	if (!World || !CharacterClass) return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	const FTransform SpawnTransform(Origin.GetRotation(), Origin.TransformPosition(Offset));
+	AAnonCharacter* Character = World->SpawnActor<AAnonCharacter>(CharacterClass, SpawnTransform, SpawnParams);
+	if (!Character) return nullptr;
+
+	UClass* ControllerClass = LoadClass<APlayerController>(nullptr, PlayerControllerClassPath);
+	if (bWithPlayer && !PlayerController && ControllerClass)
+	{
+		// The camera manager is spawned in PostInitializeComponents, pick it before finishing the spawn
+		PlayerController = World->SpawnActorDeferred<APlayerController>(ControllerClass, SpawnTransform);
+		if (UClass* CameraManagerClass = LoadClass<APlayerCameraManager>(nullptr, CameraManagerClassPath))
+		{
+			PlayerController->PlayerCameraManagerClass = CameraManagerClass;
+		}
+		PlayerController->FinishSpawning(SpawnTransform);
+		PlayerController->Possess(Character);
+	}
+
+	if (!Character->GetController())
+	{
+		Character->SpawnDefaultController();
+	}
+	return Character;
+}
+
+void FLocomotionTestWorld::Tick(float DeltaTime)
+{
+	FApp::SetDeltaTime(DeltaTime);
+	FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+
+	World->Tick(LEVELTICK_All, DeltaTime);
+
+	if (PlayerController && PlayerController->PlayerCameraManager)
+	{
+		PlayerController->PlayerCameraManager->UpdateCamera(DeltaTime);
+	}
+}
+
+void FLocomotionTestWorld::ReplayFrame(const FLocomotionInputFrame& Frame, TConstArrayView<AAnonCharacter*> Characters)
+{
+	for (AAnonCharacter* Character : Characters)
+	{
+		if (::IsValid(Character))
+		{
+			Character->ReplayInputFrame(Frame);
+		}
+	}
+
+	Tick(Frame.DeltaTime);
+}
+
+FLocomotionInputRecording FLocomotionTestWorld::MakeScriptedRecording()
+{
+	constexpr int32 FramesPerSecond = 60;
+	constexpr int32 SegmentFrames = 3 * FramesPerSecond;
+
+	// One action pressed at the start of each segment, the move input held through the segment when set
+	struct FSegment
+	{
+		ELocomotionInputAction Action;
+		bool bPressed;
+		bool bMove;
+	};
+	static const FSegment Segments[] = {
+		{ELocomotionInputAction::Num, false, false},				// Idle
+		{ELocomotionInputAction::Num, false, true},					// Running
+		{ELocomotionInputAction::Sprint, true, true},				// Sprinting
+		{ELocomotionInputAction::Sprint, false, true},				// Running
+		{ELocomotionInputAction::Walk, true, true},					// Walking
+		{ELocomotionInputAction::Walk, true, false},				// Idle
+		{ELocomotionInputAction::Stance, true, false},				// Crouching
+		{ELocomotionInputAction::Stance, true, false},				// Standing
+		{ELocomotionInputAction::Aim, true, false},					// Aiming
+		{ELocomotionInputAction::Aim, false, false},				// Idle
+		{ELocomotionInputAction::CameraTap, true, false},			// Other shoulder
+		{ELocomotionInputAction::CameraTap, true, false},			// Back to the first shoulder
+		{ELocomotionInputAction::CameraHeld, true, false},			// First person
+		{ELocomotionInputAction::CameraHeld, true, true},			// Third person, moving
+		{ELocomotionInputAction::VelocityDirection, true, true},	// Velocity direction
+		{ELocomotionInputAction::LookingDirection, true, true},		// Looking direction
+	};
+
+	FLocomotionInputRecording Recording;
+	Recording.Frames.Reserve(UE_ARRAY_COUNT(Segments) * SegmentFrames);
+
+	for (int32 SegmentIndex = 0; SegmentIndex < UE_ARRAY_COUNT(Segments); ++SegmentIndex)
+	{
+		const FSegment& Segment = Segments[SegmentIndex];
+		for (int32 i = 0; i < SegmentFrames; ++i)
+		{
+			FLocomotionInputFrame& Frame = Recording.Frames.AddDefaulted_GetRef();
+			Frame.DeltaTime = 1.0f / FramesPerSecond;
+
+			// Slow turn so the camera and the rotation modes have something to follow
+			Frame.ControlRotation = FRotator(-10.0f, Recording.Frames.Num() * 0.25f, 0.0f);
+
+			if (i == 0 && Segment.Action != ELocomotionInputAction::Num)
+			{
+				Frame.Events.Add({Segment.Action, FVector2D(Segment.bPressed ? 1.0 : 0.0, 0.0)});
+			}
+			if (Segment.bMove)
+			{
+				Frame.Events.Add({ELocomotionInputAction::Move, FVector2D(0.0, 1.0)});
+			}
+		}
+	}
+
+	return Recording;
+}
+
+#endif
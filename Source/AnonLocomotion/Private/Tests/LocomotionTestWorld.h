@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Library/LocomotionReplay.h"
+
+class AAnonCharacter;
+class APlayerController;
+
+/**
+ * The demo level loaded into its own game world and ticked by hand with fixed delta times, for tests that need
+ * characters, their anim graphs and a camera. Destroyed with the object.
+ */
+class FLocomotionTestWorld
+{
+public:
+	static const TCHAR* DemoLevel;
+	static const TCHAR* CharacterClassPath;
+	static const TCHAR* PlayerControllerClassPath;
+	static const TCHAR* CameraManagerClassPath;
+
+	explicit FLocomotionTestWorld(const TCHAR* MapName = DemoLevel);
+	~FLocomotionTestWorld();
+
+	FORCEINLINE UWorld* GetWorld() const { return World; }
+	FORCEINLINE bool IsValid() const { return World != nullptr; }
+
+	/**
+	 * Character at Offset from the level's player start. With bWithPlayer, the first one is possessed by a player
+	 * controller using the demo camera manager, the others get their default controller
+	 */
+	AAnonCharacter* SpawnCharacter(const FVector& Offset = FVector::ZeroVector, bool bWithPlayer = false);
+
+	FORCEINLINE APlayerController* GetPlayerController() const { return PlayerController; }
+
+	void Tick(float DeltaTime);
+
+	/** Replay one frame on every character, tick the world and update the player camera */
+	void ReplayFrame(const FLocomotionInputFrame& Frame, TConstArrayView<AAnonCharacter*> Characters);
+
+	/**
+	 * 48 seconds at 60 fps going through idle, running, sprinting, walking, crouching, aiming, both shoulders, first
+	 * person and both rotation modes, each held for 3 seconds.
+	 */
+	static FLocomotionInputRecording MakeScriptedRecording();
+
+private:
+	UWorld* World = nullptr;
+	APlayerController* PlayerController = nullptr;
+	FTransform Origin = FTransform::Identity;
+};
+
+#endif
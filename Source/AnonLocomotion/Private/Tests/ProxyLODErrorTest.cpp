@@ -0,0 +1,168 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Characters/AnonCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "Tests/LocomotionTestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAnonProxyLODErrorTest, "AnonLocomotion.Network.ProxyLODError",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+namespace
+{
+	constexpr float NetUpdateInterval = 1.0f / 30.0f;
+	constexpr float WarmupTime = 0.5f;
+
+	constexpr float MaxPositionError = 1.0f;
+	constexpr float MaxMeanYawError = 5.0f;
+	constexpr float MaxYawError = 30.0f;
+
+	/** Idle, running forward while turning, stopping, strafing right while looking ahead. No discrete state changes */
+	FLocomotionInputRecording MakeMovementRecording()
+	{
+		constexpr float DeltaTime = 1.0f / 60.0f;
+		constexpr int32 NumFrames = 12 * 60;
+
+		FLocomotionInputRecording Recording;
+		Recording.Frames.Reserve(NumFrames);
+
+		float Yaw = 0.0f;
+		for (int32 i = 0; i < NumFrames; ++i)
+		{
+			const float Time = i * DeltaTime;
+
+			FLocomotionInputFrame& Frame = Recording.Frames.AddDefaulted_GetRef();
+			Frame.DeltaTime = DeltaTime;
+
+			if (Time >= 2.0f && Time < 6.0f)
+			{
+				Yaw += 45.0f * DeltaTime;
+				Frame.Events.Add({ELocomotionInputAction::Move, FVector2D(0.0, 1.0)});
+			}
+			else if (Time >= 7.0f && Time < 11.0f)
+			{
+				Frame.Events.Add({ELocomotionInputAction::Move, FVector2D(1.0, 0.0)});
+			}
+			Frame.ControlRotation = FRotator(0.0f, Yaw, 0.0f);
+		}
+		return Recording;
+	}
+
+	/** Turn a spawned character into an uncontrolled simulated proxy, it then only moves by what gets "replicated" */
+	void MakeSimulatedProxy(AAnonCharacter& Character)
+	{
+		if (AController* Controller = Character.GetController())
+		{
+			Controller->UnPossess();
+			Controller->Destroy();
+		}
+		Character.SetRole(ROLE_SimulatedProxy);
+	}
+
+	/** What a net update of the authority brings to a simulated proxy: transform, velocity and the locomotion input */
+	void ReceiveNetUpdate(AAnonCharacter& Proxy, const AAnonCharacter& Authority)
+	{
+		Proxy.SetActorLocationAndRotation(Authority.GetActorLocation(), Authority.GetActorRotation());
+		Proxy.GetCharacterMovement()->Velocity = Authority.GetVelocity();
+
+		static const FName NAME_ReplicatedLocomotionInput(TEXT("ReplicatedLocomotionInput"));
+		const FProperty* Property = FindFProperty<FProperty>(AAnonCharacter::StaticClass(), NAME_ReplicatedLocomotionInput);
+		if (Property)
+		{
+			Property->CopyCompleteValue_InContainer(&Proxy, &Authority);
+		}
+	}
+}
+
+/**
+ * Drives one authority character with scripted moves and feeds its net updates to two simulated proxies: one kept at
+ * full fidelity, one reduced by the proxy LOD (it is never rendered here). The reduced proxy's position and rotation
+ * must stay close to the full rate one.
+ */
+bool FAnonProxyLODErrorTest::RunTest(const FString& Parameters)
+{
+	FLocomotionTestWorld TestWorld;
+	if (!TestTrue(TEXT("Demo level loaded"), TestWorld.IsValid())) return false;
+
+	AAnonCharacter* Authority = TestWorld.SpawnCharacter();
+	AAnonCharacter* FullProxy = TestWorld.SpawnCharacter();
+	AAnonCharacter* ReducedProxy = TestWorld.SpawnCharacter();
+	if (!TestNotNull(TEXT("Authority"), Authority) || !TestNotNull(TEXT("Full proxy"), FullProxy)
+		|| !TestNotNull(TEXT("Reduced proxy"), ReducedProxy))
+	{
+		return false;
+	}
+
+	// All three share one spot, they must not push each other around
+	for (AAnonCharacter* Character : {Authority, FullProxy, ReducedProxy})
+	{
+		Character->GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+	}
+
+	MakeSimulatedProxy(*FullProxy);
+	MakeSimulatedProxy(*ReducedProxy);
+
+	// Nothing renders in this world, an endless not rendered time keeps the full proxy out of the LOD
+	static const FName NAME_ProxyLODNotRenderedTime(TEXT("ProxyLODNotRenderedTime"));
+	FFloatProperty* NotRenderedTime =
+		FindFProperty<FFloatProperty>(AAnonCharacter::StaticClass(), NAME_ProxyLODNotRenderedTime);
+	if (!TestNotNull(TEXT("ProxyLODNotRenderedTime"), NotRenderedTime)) return false;
+	NotRenderedTime->SetPropertyValue_InContainer(FullProxy, TNumericLimits<float>::Max());
+
+	ReceiveNetUpdate(*FullProxy, *Authority);
+	ReceiveNetUpdate(*ReducedProxy, *Authority);
+
+	const FLocomotionInputRecording Recording = MakeMovementRecording();
+	float Time = 0.0f;
+	float TimeSinceNetUpdate = 0.0f;
+	float MaxPosition = 0.0f;
+	float MaxYaw = 0.0f;
+	double YawSum = 0.0;
+	int32 NumSamples = 0;
+
+	for (const FLocomotionInputFrame& Frame : Recording.Frames)
+	{
+		Authority->ReplayInputFrame(Frame);
+		TestWorld.Tick(Frame.DeltaTime);
+
+		Time += Frame.DeltaTime;
+		TimeSinceNetUpdate += Frame.DeltaTime;
+		if (TimeSinceNetUpdate >= NetUpdateInterval)
+		{
+			TimeSinceNetUpdate = 0.0f;
+			ReceiveNetUpdate(*FullProxy, *Authority);
+			ReceiveNetUpdate(*ReducedProxy, *Authority);
+		}
+
+		if (Time < WarmupTime) continue;
+
+		const float PositionError = FVector::Dist(FullProxy->GetActorLocation(), ReducedProxy->GetActorLocation());
+		const float YawError = FMath::Abs(FMath::FindDeltaAngleDegrees(FullProxy->GetActorRotation().Yaw,
+		                                                               ReducedProxy->GetActorRotation().Yaw));
+		MaxPosition = FMath::Max(MaxPosition, PositionError);
+		MaxYaw = FMath::Max(MaxYaw, YawError);
+		YawSum += YawError;
+		++NumSamples;
+	}
+
+	TestTrue(TEXT("Reduced proxy ticks at the LOD interval"),
+	         ReducedProxy->GetActorTickInterval() > FullProxy->GetActorTickInterval());
+	if (!TestTrue(TEXT("Frames measured"), NumSamples > 0)) return false;
+
+	const float MeanYaw = static_cast<float>(YawSum / NumSamples);
+	AddInfo(FString::Printf(TEXT("Position error max %.2f cm, yaw error mean %.2f max %.2f deg over %d frames"),
+	                        MaxPosition, MeanYaw, MaxYaw, NumSamples));
+
+	TestTrue(TEXT("Max position error"), MaxPosition <= MaxPositionError);
+	TestTrue(TEXT("Mean yaw error"), MeanYaw <= MaxMeanYawError);
+	TestTrue(TEXT("Max yaw error"), MaxYaw <= MaxYawError);
+
+	return true;
+}
+
+#endif
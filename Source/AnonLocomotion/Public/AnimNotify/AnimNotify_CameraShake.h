@@ -6,6 +6,10 @@
 #include "Animation/AnimNotifies/AnimNotify.h"
 #include "AnimNotify_CameraShake.generated.h"
 
+/**
+ * Shakes the local camera viewing the animated character, on every machine that plays the animation itself instead of
+ * sending a client RPC. Optionally also shakes local cameras near other characters, scaled down with the distance.
+ */
 UCLASS()
 class ANONLOCOMOTION_API UAnimNotify_CameraShake : public UAnimNotify
 {
@@ -18,4 +22,20 @@ class ANONLOCOMOTION_API UAnimNotify_CameraShake : public UAnimNotify
 
 	UPROPERTY(EditAnywhere, Category=AnimNotify)
 	float Scale = 1.f;
+
+	/** Also shake the cameras of nearby players, e.g. for heavy landings */
+	UPROPERTY(EditAnywhere, Category=AnimNotify)
+	bool bShakeNearbyCameras = false;
+
+	/** Full scale within this distance to the character */
+	UPROPERTY(EditAnywhere, Category=AnimNotify, meta = (EditCondition = "bShakeNearbyCameras", ClampMin = 0.0f))
+	float InnerRadius = 300.f;
+
+	/** No shake beyond this distance to the character */
+	UPROPERTY(EditAnywhere, Category=AnimNotify, meta = (EditCondition = "bShakeNearbyCameras", ClampMin = 0.0f))
+	float OuterRadius = 1500.f;
+
+	/** Exponent of the falloff between the radii, 1 is linear */
+	UPROPERTY(EditAnywhere, Category=AnimNotify, meta = (EditCondition = "bShakeNearbyCameras", ClampMin = 0.0f))
+	float Falloff = 1.f;
 };
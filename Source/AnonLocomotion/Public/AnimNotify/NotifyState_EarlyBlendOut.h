@@ -7,16 +7,25 @@
 #include "Data/LocomotionEnum.h"
 #include "NotifyState_EarlyBlendOut.generated.h"
 
+/**
+ * Stops the montage early once the character reaches one of the checked conditions. The window is registered with the
+ * character, which evaluates it on movement state, stance and movement input changes instead of every frame.
+ */
 UCLASS()
 class ANONLOCOMOTION_API UNotifyState_EarlyBlendOut : public UAnimNotifyState
 {
 	GENERATED_BODY()
 
-	virtual void NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float FrameDeltaTime,
-						const FAnimNotifyEventReference& EventReference) override;
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration,
+	                         const FAnimNotifyEventReference& EventReference) override;
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+	                       const FAnimNotifyEventReference& EventReference) override;
 
 	virtual FString GetNotifyName_Implementation() const override;
 
+	/** ThisMontage, or the montage the notify is placed in when left empty */
+	UAnimMontage* GetWindowMontage(UAnimSequenceBase* Animation) const;
+
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = AnimNotify)
 	TObjectPtr<UAnimMontage> ThisMontage = nullptr;
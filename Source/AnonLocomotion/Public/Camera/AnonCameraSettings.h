@@ -0,0 +1,31 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Data/CameraStruct.h"
+#include "AnonCameraSettings.generated.h"
+
+/**
+ * Camera parameters per character state, evaluated on the CPU instead of through the camera behavior anim graph.
+ */
+UCLASS(BlueprintType)
+class ANONLOCOMOTION_API UAnonCameraSettings : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Used when no rule matches */
+	UPROPERTY(EditAnywhere, Category = "ALS|Camera")
+	FCameraBehaviorParams DefaultParams;
+
+	UPROPERTY(EditAnywhere, Category = "ALS|Camera", meta = (ClampMin = 0.0f))
+	float DefaultBlendTime = 0.5f;
+
+	UPROPERTY(EditAnywhere, Category = "ALS|Camera")
+	TArray<FCameraStateRule> Rules;
+
+	/** Most specific rule matching the key, nullptr when none does */
+	const FCameraStateRule* FindRule(const FCameraStateKey& Key) const;
+};
@@ -7,12 +7,19 @@
 #include "Data/LocomotionEnum.h"
 #include "AnonPlayerCameraBehavior.generated.h"
 
+class AAnonCharacter;
+
 UCLASS()
 class ANONLOCOMOTION_API UAnonPlayerCameraBehavior : public UAnimInstance
 {
 	GENERATED_BODY()
 
 public:
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+
+	/** Bind to a newly possessed character and copy its states right away */
+	void SetCharacter(AAnonCharacter* NewCharacter);
+	
 	void SetRotationMode(ERotationMode RotationMode);
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Read Only Data|Character Information")
@@ -42,4 +49,11 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Read Only Data|Character Information")
 	bool bRightShoulder = false;
 
+private:
+	/** Copy discrete states only when the character's state version moved since the last sync */
+	void SyncCharacterStates(bool bForce = false);
+
+	TWeakObjectPtr<AAnonCharacter> Character;
+	
+	uint32 CachedStateVersion = 0;
 };
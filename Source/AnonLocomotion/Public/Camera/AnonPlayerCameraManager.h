@@ -4,9 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "Camera/PlayerCameraManager.h"
+#include "Data/CameraStruct.h"
+#include "Library/CameraOcclusion.h"
+#include "Library/CameraParamEvaluator.h"
+#include "Library/CameraTargetAdapter.h"
 #include "AnonPlayerCameraManager.generated.h"
 
 class AAnonCharacter;
+class UAnonCameraSettings;
+class UCameraShakeBase;
 
 UCLASS()
 class ANONLOCOMOTION_API AAnonPlayerCameraManager : public APlayerCameraManager
@@ -17,8 +23,25 @@ public:
 	AAnonPlayerCameraManager();
 	
 	void OnPossess(AAnonCharacter* NewCharacter);
-	
-	float GetCameraBehaviorParam(FName CurveName) const;
+
+	virtual void UpdateCamera(float DeltaTime) override;
+
+	/**
+	 * Start a shake on this camera only, without any RPC. Started with the next camera update, at most
+	 * MaxCameraShakesPerFrame per frame, strongest first.
+	 *
+	 * @param OuterRadius 0 to skip the distance falloff (the viewed character's own shakes), otherwise Scale fades out
+	 *                    from InnerRadius to OuterRadius around Epicenter
+	 */
+	void QueueLocalCameraShake(TSubclassOf<UCameraShakeBase> ShakeClass, float Scale, const FVector& Epicenter,
+	                           float InnerRadius = 0.0f, float OuterRadius = 0.0f, float Falloff = 1.0f);
+
+	FORCEINLINE bool UsesCameraParamEvaluator() const { return CameraSettings && !bUseLegacyCameraBehavior; }
+
+	/** Parameters of the last camera update, from whichever path is active */
+	FORCEINLINE const FCameraBehaviorParams& GetCameraParams() const { return CameraParams; }
+
+	static FCameraStateKey MakeCameraStateKey(const AAnonCharacter& Character);
 
 protected:
 	// ======================== References ======================== //
@@ -29,6 +52,59 @@ protected:
 	UPROPERTY(VisibleAnywhere, Category = "ALS|Camera")
 	TObjectPtr<USkeletalMeshComponent> CameraBehavior;
 
+	// ======================== Camera Parameters ======================== //
+
+	/** Camera parameters per character state. When set, the CameraBehavior mesh doesn't tick at all */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera")
+	TObjectPtr<UAnonCameraSettings> CameraSettings;
+
+	/** Keep reading the parameters from the CameraBehavior anim graph, for parity comparison against CameraSettings */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera")
+	bool bUseLegacyCameraBehavior = false;
+
+	FCameraParamEvaluator CameraParamEvaluator;
+
+	/** Filled once at the start of every camera update and read by all its steps */
+	FCameraBehaviorParams CameraParams;
+	
+	uint32 CachedStateVersion = 0;
+
+	/** Refresh CameraParams, from the evaluator or the legacy anim curves */
+	const FCameraBehaviorParams& UpdateCameraParams(float DeltaTime);
+	
+	/** Read every camera curve of the CameraBehavior anim instance in one walk over its curve map */
+	void GetLegacyCameraParams(FCameraBehaviorParams& OutParams) const;
+
+	// ======================== Camera Occlusion ======================== //
+
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera")
+	FCameraOcclusionSettings OcclusionSettings;
+
+	FCameraOcclusion CameraOcclusion;
+
+	/** Sockets of the possessed character resolved once, read in one batch per frame */
+	FCameraTargetAdapter CameraTarget;
+	FCameraTargetPoints CameraTargetPoints;
+
+	// ======================== Camera Shakes ======================== //
+
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera Shake", meta = (ClampMin = 0))
+	int32 MaxCameraShakesPerFrame = 2;
+
+	/** Shakes scaled below this after the falloff are not started */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera Shake", meta = (ClampMin = 0.0f))
+	float MinCameraShakeScale = 0.05f;
+
+	struct FQueuedCameraShake
+	{
+		TSubclassOf<UCameraShakeBase> ShakeClass;
+		float Scale = 0.0f;
+	};
+
+	TArray<FQueuedCameraShake, TInlineAllocator<4>> QueuedCameraShakes;
+
+	void StartQueuedCameraShakes();
+
 	// ======================== Managers ======================== //
 	
 	virtual void UpdateViewTargetInternal(FTViewTarget& OutVT, float DeltaTime) override;
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Data/FootstepStruct.h"
 #include "Data/LocomotionStruct.h"
 #include "Data/TraversalEnum.h"
 #include "Library/LocomotionEnumHelper.h"
@@ -23,6 +24,48 @@ public:
 	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
 	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
 
+	/**
+	 * Server lite mode (see AAnonCharacter::bServerLiteAnimation) replacement of the graph update, called by the
+	 * character on the game thread. Only runs the turn in place check, so the server still starts those montages, and
+	 * the yaw offset values while moving.
+	 */
+	void UpdateServerLite(float DeltaSeconds);
+
+	/**
+	 * YawOffset curve value of the locomotion cycles, from the YawOffset_FB/LR curves weighted by the velocity blend like
+	 * the graph does. Server lite mode only, where the graph doesn't run
+	 */
+	float GetServerLiteYawOffset() const;
+
+	FORCEINLINE float GetTurnInPlaceRotationScale() const { return Grounded.RotationScale; }
+
+	/** Stop montages and timers and restore every graph value to the class defaults, for pooled characters */
+	void ResetAnimationState();
+
+	// ==================== Foot IK ==================== //
+
+	/**
+	 * Ground hit of the last foot IK trace under FootLocation, if it is at most MaxAge seconds old. Read it on the game
+	 * thread outside of the animation update, the foot IK trace writes it from the worker thread.
+	 */
+	bool FindFootGroundHit(const FVector& FootLocation, float MaxRadius, float MaxDrop, float MaxAge,
+	                       FFootGroundHit& OutHit) const;
+
+	// ==================== Dynamic Montage Pool ==================== //
+
+	/**
+	 * PlaySlotAnimationAsDynamicMontage, but the montage wrapping each sequence and slot is created once and replayed
+	 * afterwards instead of allocating a new one for every transition and turn.
+	 */
+	UAnimMontage* PlayPooledSlotAnimation(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime,
+	                                      float BlendOutTime, float PlayRate, int32 LoopCount, float StartTime);
+
+	/** Pooled montage of PlayPooledSlotAnimation, created on the first request. Pooled montages are never modified */
+	UAnimMontage* FindOrCreatePooledMontage(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime,
+	                                        float BlendOutTime, int32 LoopCount);
+
+	FORCEINLINE int32 GetNumPooledMontages() const { return DynamicMontagePool.Num(); }
+
 protected:
 	// ==================== Transition ==================== //
 	
@@ -105,7 +148,7 @@ private:
 	void ResetIKOffsets(float DeltaSeconds);
 
 	void SetFootOffsets(float DeltaSeconds, FName EnableFootIKCurve, FName IKFootBone, FName RootBone,
-                          FVector& CurLocationTarget, FVector& CurLocationOffset, FRotator& CurRotationOffset) const;
+                          FVector& CurLocationTarget, FVector& CurLocationOffset, FRotator& CurRotationOffset);
 
 	// ==================== Grounded ==================== //
 
@@ -139,6 +182,10 @@ public:
 	// ==================== References ==================== //
 	TWeakObjectPtr<AAnonCharacter> Character;
 
+	/** Character state version the discrete states were last copied at */
+	uint32 CachedStateVersion = 0;
+	bool bStatesSynced = false;
+
 	// ==================== Character Information ==================== //
 	
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "Read Only Data|Character Information", Meta = (
@@ -265,6 +312,13 @@ public:
 	FName IkFootR_BoneName = FName(TEXT("ik_foot_r"));
 
 private:
+	/** Dynamic montages of PlayPooledSlotAnimation, one per sequence, slot, loop count and blend times */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAnimMontage>> DynamicMontagePool;
+
+	/** Left and right, written by SetFootOffsets */
+	FFootGroundHit FootGroundHits[2];
+
 	FTimerHandle OnPivotTimer;
 	FTimerHandle PlayDynamicTransitionTimer;
 	FTimerHandle OnJumpedTimer;
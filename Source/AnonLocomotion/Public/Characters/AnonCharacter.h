@@ -5,10 +5,16 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Data/CrowdStruct.h"
 #include "Data/LocomotionEnum.h"
 #include "Data/LocomotionStruct.h"
+#include "Data/LocomotionNetStruct.h"
+#include "Data/LocomotionRuntimeState.h"
+#include "Library/LocomotionReplay.h"
+#include "Library/MontageCurveTracker.h"
 #include "AnonCharacter.generated.h"
 
+class UDataTable;
 class UTraversalComponent;
 class UMotionWarpingComponent;
 class AAnonPlayerController;
@@ -32,9 +38,12 @@ public:
 	
 	virtual void PostInitializeComponents() override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+	                             UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
 	virtual void PossessedBy(AController* NewController) override;
 	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaTime) override;
 
 protected:
@@ -69,6 +78,17 @@ protected:
 	/* Server ragdoll pull force storage*/
 	float ServerRagdollPull = 0.0f;
 
+	/**
+	 * On dedicated servers, only tick montages instead of the whole anim graph. Rotation curves are then read from the
+	 * montage through baked tables (see FMontageCurveTracker), YawOffset from UAnonAnimInstance::GetServerLiteYawOffset
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Server")
+	bool bServerLiteAnimation = true;
+
+	bool bServerLiteAnimationActive = false;
+
+	mutable FMontageCurveTracker MontageCurves;
+
 	/* Dedicated server mesh default visibility based anim tick option*/
 	EVisibilityBasedAnimTickOption DefVisBasedTickOp;
 
@@ -115,9 +135,6 @@ protected:
 	
 	EGroundedEntryState GroundedEntryState;
 	
-	EMovementState MovementState = EMovementState::None;
-	EMovementState PrevMovementState = EMovementState::None;
-	
 	EMovementAction MovementAction = EMovementAction::None;
 
 	UPROPERTY(ReplicatedUsing = OnRep_RotationMode)
@@ -126,13 +143,9 @@ protected:
 	UPROPERTY(EditAnywhere, Replicated, Category = "ALS|Character States")
 	ERotationMode DesiredRotationMode = ERotationMode::LookingDirection;
 
-	EGait Gait = EGait::Walking;
-	
 	UPROPERTY(EditAnywhere, Replicated, Category = "ALS|Character States")
 	EGait DesiredGait = EGait::Running;
 
-	EStance Stance = EStance::Standing;
-
 	UPROPERTY(EditAnywhere, Replicated, Category = "ALS|Character States")
 	EStance DesiredStance = EStance::Standing;
 	
@@ -146,8 +159,8 @@ public:
 	
 	void SetMovementState(EMovementState NewState, bool bForce = false);
 	
-	FORCEINLINE EMovementState GetMovementState() const { return MovementState; }
-	FORCEINLINE EMovementState GetPrevMovementState() const { return PrevMovementState; }
+	FORCEINLINE EMovementState GetMovementState() const { return RuntimeState->MovementState; }
+	FORCEINLINE EMovementState GetPrevMovementState() const { return RuntimeState->PrevMovementState; }
 
 	//-- Movement Action --//
 	
@@ -160,10 +173,7 @@ public:
 	void SetStance(EStance NewStance, bool bForce = false);
 	void SetDesiredStance(EStance NewStance);
 	
-	UFUNCTION(Server, Reliable)
-	void Server_SetDesiredStance(EStance NewStance);
-	
-	FORCEINLINE EStance GetStance() const { return Stance; }
+	FORCEINLINE EStance GetStance() const { return RuntimeState->Stance; }
 	FORCEINLINE EStance GetDesiredStance() const { return DesiredStance; }
 
 	//-- Overlay Override --//
@@ -177,32 +187,20 @@ public:
 	void SetGait(EGait NewGait, bool bForce = false);
 	void SetDesiredGait(EGait NewGait);
 
-	UFUNCTION(Server, Reliable)
-	void Server_SetDesiredGait(EGait NewGait);
-
-	FORCEINLINE EGait GetGait() const { return Gait; }
+	FORCEINLINE EGait GetGait() const { return RuntimeState->Gait; }
 	FORCEINLINE EGait GetDesiredGait() const { return DesiredGait; }
 
 	//-- Rotation Mode --//
 	
 	void SetRotationMode(ERotationMode NewRotationMode, bool bForce = false);
     void SetDesiredRotationMode(ERotationMode NewRotMode);
-
-	UFUNCTION(Server, Reliable)
-	void Server_SetRotationMode(ERotationMode NewRotationMode, bool bForce);
 	
 	FORCEINLINE ERotationMode GetRotationMode() const { return RotationMode; }
     FORCEINLINE ERotationMode GetDesiredRotationMode() const { return DesiredRotationMode; }
-
-    UFUNCTION(Server, Reliable)
-    void Server_SetDesiredRotationMode(ERotationMode NewRotMode);
 	
 	//-- View Mode --//
 	
 	void SetViewMode(EViewMode NewViewMode, bool bForce = false);
-
-	UFUNCTION(Server, Reliable)
-	void Server_SetViewMode(EViewMode NewViewMode, bool bForce);
 	
 	EViewMode GetViewMode() const { return ViewMode; }
 
@@ -210,13 +208,33 @@ public:
 	
 	void SetOverlayState(EOverlayState NewState, bool bForce = false);
 	void SetGroundedEntryState(EGroundedEntryState NewState);
-
-	UFUNCTION(Server, Reliable)
-	void Server_SetOverlayState(EOverlayState NewState, bool bForce);
 	
 	FORCEINLINE EOverlayState GetOverlayState() const { return OverlayState; }
 	FORCEINLINE EGroundedEntryState GetGroundedEntryState() const { return GroundedEntryState; }
 
+	//-- Locomotion Intent --//
+
+	/** Owning client's discrete states, captured into every saved move */
+	FLocomotionIntent GetLocomotionIntent() const;
+
+	/**
+	 * Server only. Apply the intents carried by a client move before it gets simulated. Only the values the client
+	 * changed since its previous move are applied, so changes made by the server itself are not overwritten
+	 */
+	void ApplyLocomotionIntent(const FLocomotionIntent& Intent);
+
+	/**
+	 * Server only. Highest gait a client move may use: the allowed gait of the server's own states, with the sprint
+	 * checks run on the acceleration and control rotation the move starts from
+	 */
+	EGait GetMaxAllowedGaitForMove() const;
+
+protected:
+	/** Server only. Intent of the last applied client move */
+	FLocomotionIntent LastReceivedIntent;
+
+public:
+
 	// ==================== Jumping ==================== //
 
 public:
@@ -248,11 +266,23 @@ protected:
 	void Multicast_PlayMontage(UAnimMontage* Montage, float PlayRate);
 	
 	void Replicated_PlayMontage(UAnimMontage* Montage, float PlayRate);
+
+	//-- Early Blend Out --//
+
+	/** Montage windows waiting for a state change, checked only when movement state, stance or input change */
+	TArray<FEarlyBlendOutCondition, TInlineAllocator<2>> EarlyBlendOuts;
+
+	/** Stop the montages of every window whose condition currently holds */
+	void UpdateEarlyBlendOuts();
+
+public:
+	/** Stops the montage right away if the condition already holds */
+	void RegisterEarlyBlendOut(const FEarlyBlendOutCondition& Condition);
+	void UnregisterEarlyBlendOut(const UObject* Source, const UAnimMontage* Montage);
 	
 protected:
 	// ==================== Rotation System ==================== //
 
-	FRotator TargetRotation = FRotator::ZeroRotator;
 	FRotator InAirRotation = FRotator::ZeroRotator;
 
 	float YawOffset = 0.0f;
@@ -260,6 +290,9 @@ protected:
 	float CalculateGroundedRotationRate() const;
 	
 	void SetActorLocationAndTargetRotation(const FVector& NewLocation, const FRotator& NewRotation);
+
+	/** SetActorRotation that skips changes too small to see, each applied one moves the capsule and its children */
+	void ApplyActorRotation(const FRotator& NewRotation);
 	void SmoothCharacterRotation(const FRotator& Target, float TargetInterpSpeed, float ActorInterpSpeed, float DeltaTime);
 	void LimitRotation(float AimYawMin, float AimYawMax, float InterpSpeed, float DeltaTime);
 
@@ -318,6 +351,13 @@ protected:
 	UFUNCTION(Server, Reliable)
 	void Server_SetVisibleMesh(USkeletalMesh* NewSkeletalMesh);
 
+protected:
+	// ==================== Footstep System ==================== //
+
+	/** Footstep tables used by this character's animations, their FX assets start loading at BeginPlay */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Footstep System")
+	TArray<TObjectPtr<UDataTable>> FootstepTables;
+
 protected:
 	// ==================== Camera System ==================== //
 	
@@ -330,11 +370,21 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera System")
 	bool bRightShoulder = false;
 
+	/**
+	 * The camera reads the Head/root, FP_Camera and TP_CameraTrace sockets straight from the bone transforms, unless the
+	 * camera target getters below are overridden. Overrides are detected at possession by comparing them against the
+	 * base getters, enable this for one that may return the default targets at that moment.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Camera System")
+	bool bCustomCameraTargets = false;
+
 public:
 	void SetRightShoulder(bool bNewRightShoulder);
 	
 	FORCEINLINE bool IsRightShoulder() const { return bRightShoulder; }
+	FORCEINLINE bool HasCustomCameraTargets() const { return bCustomCameraTargets; }
 	
+	/** Called by the camera every frame once overridden, see bCustomCameraTargets */
 	virtual ECollisionChannel GetThirdPersonTraceParams(FVector& TraceOrigin, float& TraceRadius);
 	virtual FTransform GetThirdPersonPivotTarget();
 	virtual FVector GetFirstPersonCameraTarget();
@@ -350,32 +400,67 @@ public:
 protected:
 	// ==================== Essential Information Getters/Setters ==================== //
 
-	FVector Acceleration = FVector::ZeroVector;
-
-	bool bIsMoving = false;
-	bool bHasMovementInput = false;
-
-	FRotator LastVelocityRotation;
-	FRotator LastMovementInputRotation;
-
-	float Speed = 0.0f;
-	float MovementInputAmount = 0.0f;
-	float AimYawRate = 0.0f;
-
 	void SetEssentialValues(float DeltaTime);
 	
 public:
-	FORCEINLINE bool IsMoving() const { return bIsMoving; }
-	FORCEINLINE bool HasMovementInput() const { return bHasMovementInput; }
+	FORCEINLINE bool IsMoving() const { return RuntimeState->bIsMoving; }
+	FORCEINLINE bool HasMovementInput() const { return RuntimeState->bHasMovementInput; }
 	
-	FORCEINLINE float GetAimYawRate() const { return AimYawRate; }
-	FORCEINLINE float GetSpeed() const { return Speed; }
-	FORCEINLINE float GetMovementInputAmount() const { return MovementInputAmount; }
+	FORCEINLINE float GetAimYawRate() const { return RuntimeState->AimYawRate; }
+	FORCEINLINE float GetSpeed() const { return RuntimeState->Speed; }
+	FORCEINLINE float GetMovementInputAmount() const { return RuntimeState->MovementInputAmount; }
 	
-	FORCEINLINE FVector GetAcceleration() const { return Acceleration; }
+	FORCEINLINE FVector GetAcceleration() const { return RuntimeState->Acceleration; }
 	FORCEINLINE FVector GetMovementInput() const { return ReplicatedCurrentAcceleration; }
 
-	FORCEINLINE FRotator GetAimingRotation() const { return AimingRotation; }
+	FORCEINLINE FRotator GetAimingRotation() const { return RuntimeState->AimingRotation; }
+
+	/** Hot locomotion state block, read once per frame by the anim instance and camera instead of per-field getters */
+	FORCEINLINE const FLocomotionRuntimeState& GetRuntimeState() const { return *RuntimeState; }
+
+	/** Changes whenever any discrete state (movement state/action, stance, gait, rotation/view/overlay mode, ...) does */
+	FORCEINLINE uint32 GetStateVersion() const { return RuntimeState->StateVersion; }
+
+	/** Dedicated server without anim graph evaluation, ragdolls still evaluate it */
+	FORCEINLINE bool IsServerLiteAnimating() const
+	{
+		return bServerLiteAnimationActive && RuntimeState->MovementState != EMovementState::Ragdoll;
+	}
+
+public:
+	// ==================== Crowd ==================== //
+
+	/** Take over the state of a crowd agent hydrated into this actor, see UAnonCrowdSubsystem */
+	void ApplyCrowdAgent(const FAnonCrowdAgent& Agent);
+
+	/** Hand the state back to the crowd agent before this actor returns to the pool */
+	void WriteCrowdAgent(FAnonCrowdAgent& Agent) const;
+
+	FORCEINLINE const FDataTableRowHandle& GetMovementModel() const { return MovementModel; }
+
+	// ==================== Pooling ==================== //
+
+	/**
+	 * Restore the runtime state of a freshly spawned character (ragdoll, states, rotations, traversal, anim values)
+	 * without constructing anything again, see UAnonCharacterPoolSubsystem
+	 */
+	void ResetLocomotionState();
+
+protected:
+	// ==================== Runtime State ==================== //
+
+	/** Points into the world's ULocomotionStateSubsystem pool while playing, otherwise into FallbackRuntimeState */
+	FLocomotionRuntimeState* RuntimeState = nullptr;
+	FLocomotionRuntimeState FallbackRuntimeState;
+	FLocomotionStateHandle RuntimeStateHandle;
+
+	void RegisterRuntimeState();
+	void UnregisterRuntimeState();
+
+	/** Moves characters still registered at world teardown back to their fallback state */
+	friend class ULocomotionStateSubsystem;
+
+	FORCEINLINE void MarkStateDirty() { ++RuntimeState->StateVersion; }
 
 protected:
 	// ==================== Input ==================== //
@@ -432,6 +517,22 @@ public:
 	UFUNCTION()
 	void ChangeOverlayAction();
 
+	//-- Input Replay --//
+
+	/** Capture every input action and the control rotation per frame, for deterministic replays and benchmarks */
+	UFUNCTION(BlueprintCallable, Category = "ALS|Input")
+	void StartInputRecording();
+
+	/** @return false if nothing was recorded or the file could not be written */
+	UFUNCTION(BlueprintCallable, Category = "ALS|Input")
+	bool StopInputRecording(const FString& Filename);
+
+	/** Feed one recorded frame back into the input actions. Call before the frame's world tick */
+	void ReplayInputFrame(const FLocomotionInputFrame& Frame);
+
+protected:
+	FLocomotionInputRecorder InputRecorder;
+
 protected:
 	// ==================== State Changes ==================== //
 
@@ -441,6 +542,7 @@ protected:
 	virtual void OnStanceChanged(EStance PreviousStance);
 	virtual void OnRotationModeChanged(ERotationMode PreviousRotationMode);
 	virtual void OnGaitChanged(EGait PreviousGait);
+	virtual void OnMovementInputStarted();
 	virtual void OnViewModeChanged(EViewMode PreviousViewMode);
 	virtual void OnOverlayStateChanged(EOverlayState PreviousState);
 	virtual void OnVisibleMeshChanged(const USkeletalMesh* PreviousSkeletalMesh);
@@ -451,14 +553,88 @@ protected:
 	
 	//-- Replication --//
 	
-	float EasedMaxAcceleration = 0.0f;
-
+	/** Quantized movement input and control rotation for simulated proxies */
 	UPROPERTY(Replicated)
-	FVector ReplicatedCurrentAcceleration = FVector::ZeroVector;
+	FReplicatedLocomotionInput ReplicatedLocomotionInput;
 
-	UPROPERTY(Replicated)
+	/** Minimum change of movement input amount (relative to max acceleration) before it gets replicated again */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 0.0f, ClampMax = 1.0f))
+	float ReplicatedInputAmountThreshold = 0.02f;
+
+	/** Minimum change in degrees of movement input direction or control rotation before it gets replicated again */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 0.0f))
+	float ReplicatedRotationThreshold = 0.5f;
+
+	/** Full precision locally, decoded from ReplicatedLocomotionInput on simulated proxies */
+	FVector ReplicatedCurrentAcceleration = FVector::ZeroVector;
 	FRotator ReplicatedControlRotation = FRotator::ZeroRotator;
 
+	/** Idle characters further than this from a viewer get their net priority scaled by IdleNetPriorityScale */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 0.0f))
+	float IdleNetPriorityDistance = 2500.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 0.0f, ClampMax = 1.0f))
+	float IdleNetPriorityScale = 0.25f;
+
+	/** Net update frequency while idle, restored to the default as soon as the character moves again */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 1.0f))
+	float IdleNetUpdateFrequency = 10.0f;
+
+	/** Control rotation change in degrees that counts as aiming, a character standing still but aiming is not idle */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 0.0f))
+	float IdleControlRotationThreshold = 2.0f;
+
+	/** Seconds without aim changes before a standing character drops to the idle rate again */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Replication", meta = (ClampMin = 0.0f))
+	float IdleAimHoldTime = 1.0f;
+
+	float DefaultNetUpdateFrequency = 0.0f;
+	bool bNetIdle = false;
+
+	/** Control rotation at the last aim change and when that was */
+	FRotator NetIdleControlRotation = FRotator::ZeroRotator;
+	double LastNetAimTime = 0.0;
+	bool bNetAiming = false;
+
+	/** Server only. Lower the update rate while the character stands still */
+	void UpdateNetIdleState();
+
+	FORCEINLINE bool IsNetIdle() const
+	{
+		return !RuntimeState->bIsMoving && !RuntimeState->bHasMovementInput && !bNetAiming
+			&& MovementAction == EMovementAction::None && RuntimeState->MovementState == EMovementState::Grounded;
+	}
+
+	//-- Simulated Proxy LOD --//
+
+	/** Simulated proxies further than this from every local view drop to reduced fidelity */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Proxy LOD", meta = (ClampMin = 0.0f))
+	float ProxyLODDistance = 3000.0f;
+
+	/** Reduced proxies must come this much closer than ProxyLODDistance to return, so they don't flap at the edge */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Proxy LOD", meta = (ClampMin = 0.0f))
+	float ProxyLODHysteresis = 300.0f;
+
+	/** Proxies not rendered for this long drop to reduced fidelity regardless of distance */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Proxy LOD", meta = (ClampMin = 0.0f))
+	float ProxyLODNotRenderedTime = 0.5f;
+
+	/** Actor tick interval while reduced */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Proxy LOD", meta = (ClampMin = 0.0f))
+	float ProxyLODTickInterval = 0.1f;
+
+	/** Seconds to blend from the replicated rotation back to the locally computed one when returning */
+	UPROPERTY(EditDefaultsOnly, Category = "ALS|Proxy LOD", meta = (ClampMin = 0.0f))
+	float ProxyLODReturnBlendTime = 0.3f;
+
+	bool bProxyLOD = false;
+	float ProxyLODReturnAlpha = 1.0f;
+	float FullFidelityTickInterval = 0.0f;
+
+	/** Simulated proxies only. Switch between full and reduced fidelity */
+	void UpdateProxyLOD();
+	bool ShouldReduceProxy() const;
+
 	/** Replicated Skeletal Mesh Information*/
 	UPROPERTY(EditAnywhere, Category = "ALS|Skeletal Mesh", ReplicatedUsing = OnRep_VisibleMesh)
 	TObjectPtr<USkeletalMesh> VisibleMesh;
@@ -477,10 +653,6 @@ protected:
 	
 	//-- Cached Variables --//
 
-	FVector PreviousVelocity = FVector::ZeroVector;
-
-	float PreviousAimYaw = 0.0f;
-
 	UPROPERTY(BlueprintReadOnly, Category = "ALS|Camera")
 	TObjectPtr<UAnonPlayerCameraBehavior> CameraBehavior;
 
@@ -490,10 +662,7 @@ protected:
 	/* Timer to manage reset of braking friction factor after on landed event */
 	FTimerHandle OnLandedFrictionResetTimer;
 
-	/* Smooth out aiming by interping control rotation*/
-	FRotator AimingRotation = FRotator::ZeroRotator;
-
-	/** We won't use curve based movement and a few other features on networked games */
+	/** We won't use the few features that don't predict (input driven roll steering) on networked games */
 	bool bEnableNetworkOptimizations = false;
 
 protected:
@@ -0,0 +1,69 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Data/CrowdStruct.h"
+#include "AnonLocomotionBenchmarkCommandlet.generated.h"
+
+class AAnonCharacter;
+class APlayerController;
+struct FLocomotionInputRecording;
+
+/**
+ * Headless locomotion regression benchmark. Replays one input recording on N characters in a map and writes the per
+ * stage timings as JSON.
+ *
+ * UnrealEditor-Cmd <Project> -run=AnonLocomotionBenchmark -nullrhi -unattended
+ *     -Map=/Game/Maps/Benchmark -Recording=<file> [-Character=/Game/BP_Character.BP_Character_C] [-Copies=16]
+ *     [-Spacing=300] [-PlayerController=<class>] [-CrowdAgents=0] [-CrowdSpacing=200] [-SpawnCycles=0]
+ *     [-Output=<file.json>]
+ *
+ * -PlayerController possesses the first copy with that controller so the camera stage is measured as well.
+ * -CrowdAgents adds that many UAnonCrowdSubsystem agents of the character class, walking on a grid next to the copies.
+ * -SpawnCycles times that many spawn + destroy against acquire + release through UAnonCharacterPoolSubsystem, after
+ * the replay.
+ *
+ * Editor builds only, cooked runtime builds compile it to an empty commandlet.
+ */
+UCLASS()
+class ANONLOCOMOTION_API UAnonLocomotionBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAnonLocomotionBenchmarkCommandlet();
+
+#if WITH_EDITOR
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	static constexpr int32 OutputFormatVersion = 3;
+
+	static UWorld* LoadBenchmarkWorld(const FString& MapName);
+	static void DestroyBenchmarkWorld(UWorld* World);
+
+	static void SpawnCopies(UWorld& World, UClass* CharacterClass, int32 NumCopies, float Spacing,
+	                        UClass* PlayerControllerClass, TArray<AAnonCharacter*>& OutCharacters,
+	                        APlayerController*& OutPlayerController);
+
+	static void AddCrowdAgents(UWorld& World, UClass* CharacterClass, int32 NumAgents, float Spacing,
+	                           TArray<FAnonCrowdAgentHandle>& OutAgents);
+	/** Turns every agent a little each frame and cycles their gaits so the simulation keeps changing state */
+	static void SteerCrowdAgents(UWorld& World, const TArray<FAnonCrowdAgentHandle>& Agents, int32 FrameIndex);
+
+	struct FSpawnCost
+	{
+		int32 Cycles = 0;
+		double SpawnMs = 0.0;
+		double PooledMs = 0.0;
+	};
+
+	static FSpawnCost MeasureSpawnCost(UWorld& World, UClass* CharacterClass, int32 NumCycles);
+
+	static bool WriteReport(const FString& Filename, const FString& MapName, const FString& RecordingName,
+	                        const UClass* CharacterClass, int32 NumCopies, int32 NumCrowdAgents, int32 NumFrames,
+	                        double WallSeconds, const FSpawnCost& SpawnCost);
+#endif
+};
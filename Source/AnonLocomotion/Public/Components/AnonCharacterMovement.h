@@ -6,6 +6,8 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Data/LocomotionEnum.h"
 #include "Data/LocomotionStruct.h"
+#include "Data/LocomotionNetStruct.h"
+#include "Library/MovementCurveCache.h"
 #include "AnonCharacterMovement.generated.h"
 
 UCLASS(ClassGroup=(Anon))
@@ -20,14 +22,44 @@ class ANONLOCOMOTION_API UAnonCharacterMovement : public UCharacterMovementCompo
 		typedef FSavedMove_Character Super;
 
 		virtual void Clear() override;
-		virtual uint8 GetCompressedFlags() const override;
+		virtual bool IsImportantMove(const FSavedMovePtr& LastAckedMove) const override;
+		virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
 		virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel,
 								FNetworkPredictionData_Client_Character& ClientData) override;
 		virtual void PrepMoveFor(ACharacter* Character) override;
 
-		// Walk Speed Update
-		uint8 bSavedRequestMovementSettingsChange : 1;
+		// Gait the move was simulated with, decides the max walk speed
 		EGait SavedAllowedGait = EGait::Walking;
+
+		// Movement settings the move was simulated with, restored when it is replayed after a correction
+		FMovementSettings SavedMovementSettings;
+		uint32 SavedMovementSettingsHash = 0;
+
+		// Stance, gait, rotation/view mode and overlay requested by the owning client
+		FLocomotionIntent SavedIntent;
+	};
+
+	/** Move data sent to the server, carries the allowed gait and locomotion intents next to the regular movement values */
+	class ANONLOCOMOTION_API FAnonNetworkMoveData final : public FCharacterNetworkMoveData
+	{
+	public:
+		typedef FCharacterNetworkMoveData Super;
+
+		virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+		virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap,
+		                       ENetworkMoveType MoveType) override;
+
+		EGait AllowedGait = EGait::Walking;
+		uint32 MovementSettingsHash = 0;
+		FLocomotionIntent Intent;
+	};
+
+	class ANONLOCOMOTION_API FAnonNetworkMoveDataContainer final : public FCharacterNetworkMoveDataContainer
+	{
+	public:
+		FAnonNetworkMoveDataContainer();
+
+		FAnonNetworkMoveData MoveData[3];
 	};
 
 	class ANONLOCOMOTION_API FNetworkPredictionData_Client_Anon final : public FNetworkPredictionData_Client_Character
@@ -40,32 +72,46 @@ class ANONLOCOMOTION_API UAnonCharacterMovement : public UCharacterMovementCompo
 		virtual FSavedMovePtr AllocateNewMove() override;
 	};
 
-	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	FAnonNetworkMoveDataContainer AnonMoveDataContainer;
+
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
 	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
-	virtual void OnMovementUpdated(float DeltaTime, const FVector& OldLocation, const FVector& OldVelocity) override;
 
 public:
+	explicit UAnonCharacterMovement(const FObjectInitializer& ObjectInitializer);
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	
 	// Movement Settings Override
 	virtual void PhysWalking(float DeltaTime, int32 Iterations) override;
 	virtual float GetMaxAcceleration() const override;
 	virtual float GetMaxBrakingDeceleration() const override;
 	
 	// Movement Settings Variables
-	uint8 bRequestMovementSettingsChange = 1;
-	
 	EGait AllowedGait = EGait::Walking;
 	
 	FMovementSettings CurrentMovementSettings;
 
+	/**
+	 * CRC of CurrentMovementSettings (speeds and curve paths), equal on every machine using the same settings. Sent with
+	 * every move so the server can tell when it simulated with other settings than the client
+	 */
+	uint32 MovementSettingsHash = 0;
+
 	// Set Movement Curve (Called in every instance)
 	float GetMappedSpeed() const;
 
 	
 	void SetMovementSettings(const FMovementSettings& NewMovementSettings);
 
-	// Set Max Walking Speed (Called from the owning client)
+	// Set Max Walking Speed (Called in every instance, ignored on the server for remote clients whose gait comes with their moves)
 	void SetAllowedGait(EGait NewAllowedGait);
 
-	UFUNCTION(Reliable, Server)
-	void Server_SetAllowedGait(EGait NewAllowedGait);
+private:
+	void UpdateMaxWalkSpeed();
+
+	/** Baked CurrentMovementSettings.MovementCurve, sampled at the quantized mapped speed */
+	const FVector& GetMovementCurveValue() const;
+
+	TSharedPtr<const FBakedMovementCurve> BakedMovementCurve;
 };
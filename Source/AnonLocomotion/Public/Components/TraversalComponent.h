@@ -125,5 +125,8 @@ private:
 
 public:
 	void TriggerTraversalAction(const bool bJumpAction = false);
+
+	/** Back to free roam without any wall result, for pooled characters */
+	void ResetTraversal();
 	
 };
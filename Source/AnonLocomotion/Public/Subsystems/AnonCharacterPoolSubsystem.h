@@ -0,0 +1,50 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "AnonCharacterPoolSubsystem.generated.h"
+
+class AAnonCharacter;
+
+/**
+ * Reuses AAnonCharacter actors instead of destroying and spawning them. Released characters are hidden, without
+ * collision, tick or network updates; acquiring one places it and runs AAnonCharacter::ResetLocomotionState, so the
+ * components, the movement model lookup, the traversal debug arrow and the anim instance are not created again.
+ *
+ * Player controllers are unpossessed on release, any other controller stays with its pawn.
+ */
+UCLASS(Config = Game)
+class ANONLOCOMOTION_API UAnonCharacterPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Reuse a released character of exactly this class or spawn a new one */
+	AAnonCharacter* AcquireCharacter(TSubclassOf<AAnonCharacter> CharacterClass, const FTransform& Transform);
+
+	/** Deactivate the character and keep it for reuse, destroys it if the pool of its class is full */
+	void ReleaseCharacter(AAnonCharacter* Character);
+
+	/** Spawn and release characters up front, so the first acquisitions don't spawn either */
+	void Prewarm(TSubclassOf<AAnonCharacter> CharacterClass, int32 Count, const FTransform& Transform);
+
+	int32 GetNumPooled(TSubclassOf<AAnonCharacter> CharacterClass) const;
+
+protected:
+	UPROPERTY(Config)
+	int32 MaxPooledPerClass = 16;
+
+private:
+	AAnonCharacter* SpawnCharacter(UClass* CharacterClass, const FTransform& Transform) const;
+
+	static void Deactivate(AAnonCharacter* Character);
+	static void Activate(AAnonCharacter* Character, const FTransform& Transform);
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AAnonCharacter>> Pooled;
+};
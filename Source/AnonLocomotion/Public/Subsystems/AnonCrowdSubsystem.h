@@ -0,0 +1,131 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/CrowdStruct.h"
+#include "Data/LocomotionStruct.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "AnonCrowdSubsystem.generated.h"
+
+class AAnonCharacter;
+
+/**
+ * Crowd of lightweight locomotion agents. Agents far from every player are plain structs simulated in parallel batches:
+ * gait selection and grounded rotation follow the same FLocomotionRules as AAnonCharacter, movement is a constant
+ * acceleration towards the gait speed without collision, a few floor traces per frame keep them on the ground. Agents
+ * coming close to a player are hydrated into an AAnonCharacter of UAnonCharacterPoolSubsystem that takes over their
+ * state, and get it back when they leave again.
+ *
+ * Agents are simulated where they are added, add them on the server in networked games, clients only see the hydrated
+ * actors.
+ */
+UCLASS(Config = Game)
+class ANONLOCOMOTION_API UAnonCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** @return An invalid handle if the class has no movement model */
+	FAnonCrowdAgentHandle AddAgent(TSubclassOf<AAnonCharacter> CharacterClass, const FTransform& Transform);
+
+	/** Remove the agent together with its actor, handle gets invalidated */
+	void RemoveAgent(FAnonCrowdAgentHandle& Handle);
+
+	/** Desired movement direction scaled by the input amount (0-1), kept until changed */
+	void SetAgentMovementInput(FAnonCrowdAgentHandle Handle, const FVector& MovementInput);
+	void SetAgentAimingRotation(FAnonCrowdAgentHandle Handle, const FRotator& AimingRotation);
+	void SetAgentDesiredGait(FAnonCrowdAgentHandle Handle, EGait DesiredGait);
+	void SetAgentStance(FAnonCrowdAgentHandle Handle, EStance Stance);
+	void SetAgentRotationMode(FAnonCrowdAgentHandle Handle, ERotationMode RotationMode);
+
+	/** @return nullptr for a stale handle */
+	const FAnonCrowdAgent* GetAgent(FAnonCrowdAgentHandle Handle) const;
+
+	/** @return The actor representing the agent, nullptr while it's simulated in the batch */
+	AAnonCharacter* GetAgentActor(FAnonCrowdAgentHandle Handle) const;
+
+	FORCEINLINE int32 GetNumAgents() const { return Agents.Num() - FreeIndices.Num(); }
+	FORCEINLINE int32 GetNumHydratedAgents() const { return NumHydrated; }
+
+	/** Advance every agent that has no actor */
+	void SimulateAgents(float DeltaTime);
+
+protected:
+	/** Agents closer than this to a player get an actor */
+	UPROPERTY(Config)
+	float HydrateDistance = 2500.0f;
+
+	/** Extra distance before a hydrated agent goes back to the batch, so agents on the border don't flip every frame */
+	UPROPERTY(Config)
+	float DehydrateHysteresis = 500.0f;
+
+	UPROPERTY(Config)
+	int32 MaxHydratedAgents = 32;
+
+	/** Actors taken from the pool (or spawned) per frame, the rest waits for the next frames */
+	UPROPERTY(Config)
+	int32 MaxHydrationsPerFrame = 2;
+
+	//-- Simulation --//
+
+	UPROPERTY(Config)
+	float MaxAcceleration = 1500.0f;
+
+	UPROPERTY(Config)
+	float BrakingDeceleration = 2000.0f;
+
+	/** Agents per parallel task */
+	UPROPERTY(Config)
+	int32 AgentsPerBatch = 256;
+
+	/** Floor traces per frame, agents take turns so each one is snapped every NumAgents / MaxFloorSnapsPerFrame frames */
+	UPROPERTY(Config)
+	int32 MaxFloorSnapsPerFrame = 64;
+
+	/** How far below its feet an agent still finds its floor, it keeps its height when walking off a higher ledge */
+	UPROPERTY(Config)
+	float FloorSnapDistance = 100.0f;
+
+private:
+	FAnonCrowdAgent* FindAgent(FAnonCrowdAgentHandle Handle);
+	int32 FindOrAddArchetype(TSubclassOf<AAnonCharacter> CharacterClass);
+
+	void GatherViewers();
+	void SyncHydratedAgents();
+	void SnapAgentsToFloor();
+	void UpdateHydration();
+	void Hydrate(int32 Index);
+	void Dehydrate(int32 Index);
+
+	TArray<FAnonCrowdAgent> Agents;
+	TArray<int32> FreeIndices;
+	uint32 NextSerial = 1;
+	int32 NumHydrated = 0;
+	/** Next agent to snap to the floor */
+	int32 FloorSnapCursor = 0;
+
+	/** Actor of each agent, same indices as Agents */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AAnonCharacter>> AgentActors;
+
+	TArray<FVector, TInlineAllocator<4>> ViewerLocations;
+
+	//-- Archetypes --//
+
+	/** Character class and movement model shared by all agents of that class */
+	UPROPERTY(Transient)
+	TArray<TSubclassOf<AAnonCharacter>> ArchetypeClasses;
+
+	UPROPERTY(Transient)
+	TArray<FMovementStateSettings> ArchetypeMovementData;
+
+	/** Capsule half height of the class defaults, agent locations are capsule centers like the actor locations */
+	TArray<float> ArchetypeHalfHeights;
+};
@@ -0,0 +1,164 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/FootstepStruct.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "FootstepFXSubsystem.generated.h"
+
+class UAudioComponent;
+class UDataTable;
+class UDecalComponent;
+class UMaterialInterface;
+class UNiagaraSystem;
+class UPhysicalMaterial;
+class UPrimitiveComponent;
+class USoundBase;
+
+/**
+ * Plays the queued footsteps once per frame from preloaded assets and pooled components, reusing the foot IK ground
+ * hits or tracing asynchronously (one frame late). Only the most significant footsteps of each FX type are played.
+ */
+UCLASS(Config = Game)
+class ANONLOCOMOTION_API UFootstepFXSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickableInEditor() const override { return true; }
+
+	/** Start loading every asset the table references, cheap to call again for a known table */
+	void RegisterTable(const UDataTable* Table);
+
+	/** Resolved at the end of the frame, played once its ground hit is known if significant and within budget */
+	void QueueFootstep(const FFootstepFXRequest& Request);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Audio voices kept for footsteps, the oldest one is reused when all are playing */
+	UPROPERTY(Config)
+	int32 AudioPoolSize = 32;
+
+	/** Footstep decals alive at once, the oldest one is recycled first */
+	UPROPERTY(Config)
+	int32 DecalPoolSize = 64;
+
+	//-- Ground Trace --//
+
+	/** Foot IK ground hits older than this are traced again */
+	UPROPERTY(Config)
+	float MaxFootIKHitAge = 0.1f;
+
+	/** Horizontal distance between the footstep socket and the foot IK hit to still count as the same foot */
+	UPROPERTY(Config)
+	float FootIKHitRadius = 25.0f;
+
+	/** Async traces without a result after this many frames are dropped, e.g. after a world shift */
+	UPROPERTY(Config)
+	int32 MaxTraceLatencyFrames = 4;
+
+	//-- Significance --//
+
+	UPROPERTY(Config)
+	float MaxSoundDistance = 3000.0f;
+
+	UPROPERTY(Config)
+	float MaxNiagaraDistance = 2000.0f;
+
+	UPROPERTY(Config)
+	float MaxDecalDistance = 2000.0f;
+
+	/** Skip Niagara and decals of characters that were not rendered recently, sounds still play */
+	UPROPERTY(Config)
+	bool bCullHiddenVisualFX = true;
+
+	//-- Budget --//
+
+	UPROPERTY(Config)
+	int32 MaxSoundsPerFrame = 6;
+
+	UPROPERTY(Config)
+	int32 MaxNiagaraPerFrame = 6;
+
+	UPROPERTY(Config)
+	int32 MaxDecalsPerFrame = 4;
+
+	/** Same sound started within this distance in the same frame reuses the first voice, slightly louder */
+	UPROPERTY(Config)
+	float CoalesceRadius = 400.0f;
+
+	UPROPERTY(Config)
+	float MaxCoalescedVolume = 1.5f;
+
+private:
+	void ConsumeTraces();
+	void ResolveQueued();
+	void ResolveRequest(FFootstepFXRequest& Request, const FVector& HitLocation, const UPhysicalMaterial* PhysMaterial,
+	                    const TWeakObjectPtr<UPrimitiveComponent>& HitComponent);
+	void DrawDebugTrace(const FFootstepFXRequest& Request, const FVector& Start, const FVector& End,
+	                    const FHitResult* Hit) const;
+
+	void UpdateSignificance(FFootstepFXRequest& Request) const;
+	void ProcessQueue();
+
+	/** @return true if the sound joined a voice started earlier this frame */
+	bool TryCoalesceSound(const FFootstepFXRequest& Request, const USoundBase* Sound);
+
+	UAudioComponent* PlaySound(const FFootstepFXRequest& Request, USoundBase* Sound);
+	void PlayNiagara(const FFootstepFXRequest& Request, UNiagaraSystem* System) const;
+	void PlayDecal(const FFootstepFXRequest& Request, UMaterialInterface* Material);
+
+	UAudioComponent* AcquireAudioComponent();
+	/** @return Index into DecalPool */
+	int32 AcquireDecal();
+
+	struct FCoalescedVoice
+	{
+		const USoundBase* Sound = nullptr;
+		FVector Location = FVector::ZeroVector;
+		TWeakObjectPtr<UAudioComponent> Component;
+		float Volume = 0.0f;
+	};
+
+	struct FPendingTrace
+	{
+		FFootstepFXRequest Request;
+		FTraceHandle Handle;
+		uint64 FrameIssued = 0;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+	};
+
+	/** Queued this frame, ground not traced yet */
+	TArray<FFootstepFXRequest> QueuedRequests;
+	TArray<FPendingTrace> PendingTraces;
+	/** Ground resolved, waiting for significance and budget */
+	TArray<FFootstepFXRequest> ReadyRequests;
+	TArray<FVector, TInlineAllocator<4>> ListenerLocations;
+	TArray<FCoalescedVoice, TInlineAllocator<16>> FrameVoices;
+
+	//-- Preload --//
+	FStreamableManager StreamableManager;
+	TArray<TSharedPtr<FStreamableHandle>> LoadHandles;
+	TSet<TObjectKey<UDataTable>> RegisteredTables;
+
+	//-- Pools --//
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioComponent>> AudioPool;
+	int32 NextAudio = 0;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UDecalComponent>> DecalPool;
+	TArray<double> DecalExpireTimes;
+	int32 NextDecal = 0;
+};
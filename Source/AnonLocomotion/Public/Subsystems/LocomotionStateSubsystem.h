@@ -0,0 +1,52 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ChunkedArray.h"
+#include "Data/LocomotionRuntimeState.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LocomotionStateSubsystem.generated.h"
+
+class AAnonCharacter;
+
+/**
+ * World-owned pool of FLocomotionRuntimeState blocks. Blocks are stored in fixed size chunks, so they are contiguous
+ * for batch processing and never move once acquired (the anim thread can read them while other characters spawn).
+ */
+UCLASS()
+class ANONLOCOMOTION_API ULocomotionStateSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Reserve a block for a character and initialize it with its current state */
+	FLocomotionStateHandle Acquire(const FLocomotionRuntimeState& InitialState, AAnonCharacter* Owner);
+
+	/** Return a block to the pool, handle gets invalidated */
+	void Release(FLocomotionStateHandle& Handle);
+
+	FORCEINLINE FLocomotionRuntimeState& Get(const FLocomotionStateHandle Handle)
+	{
+		check(Handle.IsValid() && ActiveStates[Handle.Index]);
+		return States[Handle.Index];
+	}
+
+	FORCEINLINE int32 GetNumActiveStates() const { return States.Num() - FreeIndices.Num(); }
+
+	/** Iterate every block currently owned by a character, in memory order */
+	void ForEachActiveState(TFunctionRef<void(FLocomotionStateHandle, FLocomotionRuntimeState&)> Func);
+
+	/** Copy every active block into OutSnapshot, reusing its allocation */
+	void TakeSnapshot(TArray<FLocomotionRuntimeState>& OutSnapshot) const;
+
+private:
+	TChunkedArray<FLocomotionRuntimeState> States;
+	TBitArray<> ActiveStates;
+	TArray<int32> FreeIndices;
+
+	/** Character holding a pointer into each block, pointed back to its fallback state before the pool goes away */
+	TArray<TWeakObjectPtr<AAnonCharacter>> Owners;
+};